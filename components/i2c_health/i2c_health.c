@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2c_health.h"
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef enum {
+    I2C_HEALTH_OP_TX,
+    I2C_HEALTH_OP_RX,
+    I2C_HEALTH_OP_TX_RX,
+} i2c_health_op_t;
+
+typedef struct {
+    i2c_health_op_t op;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    int timeout_ms;
+} i2c_health_xfer_t;
+
+typedef struct {
+    i2c_master_bus_handle_t bus;
+    i2c_master_dev_handle_t dev;
+    i2c_health_config_t config;
+    portMUX_TYPE lock;              /*!< Guards stats against concurrent readers */
+    i2c_health_stats_t stats;
+} i2c_health_dev_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static esp_err_t i2c_health_run(i2c_health_dev_t *hdev, const i2c_health_xfer_t *xfer);
+static esp_err_t i2c_health_attempt(i2c_health_dev_t *hdev, const i2c_health_xfer_t *xfer);
+static void i2c_health_backoff(uint32_t delay_us);
+static uint32_t i2c_health_latency_bin(uint32_t latency_us);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "I2C_HEALTH";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t i2c_health_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *dev_config,
+                                const i2c_health_config_t *config, i2c_health_dev_handle_t *handle_ret)
+{
+    esp_err_t ret = ESP_OK;
+    const i2c_health_config_t default_config = I2C_HEALTH_CONFIG_DEFAULT();
+
+    assert(dev_config != NULL && handle_ret != NULL);
+
+    i2c_health_dev_t *hdev = (i2c_health_dev_t *) calloc(1, sizeof(i2c_health_dev_t));
+    ESP_RETURN_ON_FALSE(hdev != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+    hdev->bus = bus;
+    hdev->config = config ? *config : default_config;
+    portMUX_INITIALIZE(&hdev->lock);
+
+    ESP_GOTO_ON_ERROR(i2c_master_bus_add_device(bus, dev_config, &hdev->dev), err, TAG, "Failed to add new I2C device");
+
+    *handle_ret = hdev;
+    return ret;
+
+err:
+    free(hdev);
+    return ret;
+}
+
+void i2c_health_rm_device(i2c_health_dev_handle_t dev)
+{
+    i2c_health_dev_t *hdev = (i2c_health_dev_t *) dev;
+
+    i2c_master_bus_rm_device(hdev->dev);
+    free(hdev);
+}
+
+i2c_master_dev_handle_t i2c_health_get_i2c_dev(i2c_health_dev_handle_t dev)
+{
+    return ((i2c_health_dev_t *) dev)->dev;
+}
+
+esp_err_t i2c_health_transmit(i2c_health_dev_handle_t dev, const uint8_t *data, size_t len, int timeout_ms)
+{
+    const i2c_health_xfer_t xfer = {
+        .op = I2C_HEALTH_OP_TX,
+        .tx = data,
+        .tx_len = len,
+        .timeout_ms = timeout_ms,
+    };
+    return i2c_health_run((i2c_health_dev_t *) dev, &xfer);
+}
+
+esp_err_t i2c_health_receive(i2c_health_dev_handle_t dev, uint8_t *data, size_t len, int timeout_ms)
+{
+    const i2c_health_xfer_t xfer = {
+        .op = I2C_HEALTH_OP_RX,
+        .rx = data,
+        .rx_len = len,
+        .timeout_ms = timeout_ms,
+    };
+    return i2c_health_run((i2c_health_dev_t *) dev, &xfer);
+}
+
+esp_err_t i2c_health_transmit_receive(i2c_health_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                                      uint8_t *rx, size_t rx_len, int timeout_ms)
+{
+    const i2c_health_xfer_t xfer = {
+        .op = I2C_HEALTH_OP_TX_RX,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .rx_len = rx_len,
+        .timeout_ms = timeout_ms,
+    };
+    return i2c_health_run((i2c_health_dev_t *) dev, &xfer);
+}
+
+void i2c_health_get_stats(i2c_health_dev_handle_t dev, i2c_health_stats_t *stats)
+{
+    i2c_health_dev_t *hdev = (i2c_health_dev_t *) dev;
+
+    assert(stats != NULL);
+
+    portENTER_CRITICAL(&hdev->lock);
+    *stats = hdev->stats;
+    portEXIT_CRITICAL(&hdev->lock);
+}
+
+void i2c_health_reset_stats(i2c_health_dev_handle_t dev)
+{
+    i2c_health_dev_t *hdev = (i2c_health_dev_t *) dev;
+
+    portENTER_CRITICAL(&hdev->lock);
+    memset(&hdev->stats, 0, sizeof(hdev->stats));
+    portEXIT_CRITICAL(&hdev->lock);
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static esp_err_t i2c_health_run(i2c_health_dev_t *hdev, const i2c_health_xfer_t *xfer)
+{
+    uint32_t delay_us = hdev->config.backoff_base_us;
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret;
+
+    for (uint32_t attempt = 0; ; attempt++) {
+        ret = i2c_health_attempt(hdev, xfer);
+
+        bool reset = false;
+        portENTER_CRITICAL(&hdev->lock);
+        switch (ret) {
+        case ESP_OK:
+            break;
+        case ESP_ERR_INVALID_RESPONSE:
+            hdev->stats.nacks++;
+            break;
+        case ESP_ERR_TIMEOUT:
+            hdev->stats.timeouts++;
+            reset = true;
+            break;
+        default:
+            hdev->stats.other_errors++;
+            break;
+        }
+        portEXIT_CRITICAL(&hdev->lock);
+
+        if (ret == ESP_OK || attempt >= hdev->config.max_retries) {
+            break;
+        }
+
+        /* A timeout usually means a slave is holding SDA low after an aborted transfer */
+        if (reset && i2c_master_bus_reset(hdev->bus) == ESP_OK) {
+            portENTER_CRITICAL(&hdev->lock);
+            hdev->stats.bus_resets++;
+            portEXIT_CRITICAL(&hdev->lock);
+        }
+
+        i2c_health_backoff(delay_us);
+        delay_us = (delay_us > hdev->config.backoff_max_us / 2) ? hdev->config.backoff_max_us : delay_us * 2;
+
+        portENTER_CRITICAL(&hdev->lock);
+        hdev->stats.retries++;
+        portEXIT_CRITICAL(&hdev->lock);
+    }
+
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - start);
+
+    portENTER_CRITICAL(&hdev->lock);
+    hdev->stats.transfers++;
+    if (ret == ESP_OK) {
+        hdev->stats.latency_hist[i2c_health_latency_bin(latency_us)]++;
+        if (latency_us > hdev->stats.max_latency_us) {
+            hdev->stats.max_latency_us = latency_us;
+        }
+    } else {
+        hdev->stats.failures++;
+    }
+    portEXIT_CRITICAL(&hdev->lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Transfer failed after %u retries: %s", hdev->config.max_retries, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static esp_err_t i2c_health_attempt(i2c_health_dev_t *hdev, const i2c_health_xfer_t *xfer)
+{
+    switch (xfer->op) {
+    case I2C_HEALTH_OP_TX:
+        return i2c_master_transmit(hdev->dev, xfer->tx, xfer->tx_len, xfer->timeout_ms);
+    case I2C_HEALTH_OP_RX:
+        return i2c_master_receive(hdev->dev, xfer->rx, xfer->rx_len, xfer->timeout_ms);
+    default:
+        return i2c_master_transmit_receive(hdev->dev, xfer->tx, xfer->tx_len, xfer->rx, xfer->rx_len, xfer->timeout_ms);
+    }
+}
+
+/* Busy-wait below one tick, yield to other tasks above it */
+static void i2c_health_backoff(uint32_t delay_us)
+{
+    const uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+
+    if (delay_us >= tick_us) {
+        vTaskDelay((delay_us + tick_us - 1) / tick_us);
+    } else if (delay_us > 0) {
+        esp_rom_delay_us(delay_us);
+    }
+}
+
+static uint32_t i2c_health_latency_bin(uint32_t latency_us)
+{
+    uint32_t bin = (latency_us == 0) ? 0 : 32 - __builtin_clz(latency_us);
+
+    return (bin < I2C_HEALTH_LATENCY_BINS) ? bin : I2C_HEALTH_LATENCY_BINS - 1;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Transfer latency histogram: bin 0 counts calls under 1 us, bin n counts
+ * [2^(n-1), 2^n) us and the last bin everything from 2^(BINS-2) us up.
+ */
+#define I2C_HEALTH_LATENCY_BINS     16
+
+typedef struct {
+    uint8_t max_retries;        /*!< Retries after the first attempt */
+    uint32_t backoff_base_us;   /*!< Delay before the first retry, doubled on each further retry */
+    uint32_t backoff_max_us;    /*!< Upper bound on the retry delay */
+} i2c_health_config_t;
+
+#define I2C_HEALTH_CONFIG_DEFAULT() {                       \
+    .max_retries = CONFIG_I2C_HEALTH_MAX_RETRIES,           \
+    .backoff_base_us = CONFIG_I2C_HEALTH_BACKOFF_BASE_US,   \
+    .backoff_max_us = CONFIG_I2C_HEALTH_BACKOFF_MAX_US,     \
+}
+
+typedef struct {
+    uint32_t transfers;         /*!< Calls into transmit/receive */
+    uint32_t failures;          /*!< Calls that still failed after all retries */
+    uint32_t retries;           /*!< Repeated attempts */
+    uint32_t nacks;             /*!< Attempts the device did not acknowledge */
+    uint32_t timeouts;          /*!< Attempts that timed out */
+    uint32_t other_errors;      /*!< Attempts that failed for any other reason */
+    uint32_t bus_resets;        /*!< Bus recoveries issued after a timeout */
+    uint32_t max_latency_us;    /*!< Slowest successful call, retries included */
+    uint32_t latency_hist[I2C_HEALTH_LATENCY_BINS];  /*!< Successful calls by latency */
+} i2c_health_stats_t;
+
+typedef void *i2c_health_dev_handle_t;
+
+/**
+ * @brief Add a device to the bus behind the retry and accounting layer
+ *
+ * @param[in]  bus        I2C bus, from i2c_new_master_bus()
+ * @param[in]  dev_config device configuration, passed to i2c_master_bus_add_device()
+ * @param[in]  config     retry policy, NULL for I2C_HEALTH_CONFIG_DEFAULT()
+ * @param[out] handle_ret handle to the created device
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NO_MEM Not enough memory for the driver
+ *     - Others Error from underlying I2C driver
+ */
+esp_err_t i2c_health_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *dev_config,
+                                const i2c_health_config_t *config, i2c_health_dev_handle_t *handle_ret);
+
+/**
+ * @brief Remove a device and release its resources
+ *
+ * @param dev device handle
+ */
+void i2c_health_rm_device(i2c_health_dev_handle_t dev);
+
+/**
+ * @brief Get the underlying I2C master device handle
+ *
+ * @param dev device handle
+ *
+ * @return I2C master device handle
+ */
+i2c_master_dev_handle_t i2c_health_get_i2c_dev(i2c_health_dev_handle_t dev);
+
+/**
+ * @brief Write to the device, retrying on failure
+ *
+ * A timed-out attempt is followed by a bus reset, which clocks SCL until a
+ * slave holding SDA low lets go, before the next retry.
+ *
+ * @param dev        device handle
+ * @param data       bytes to send
+ * @param len        number of bytes
+ * @param timeout_ms timeout of each attempt, -1 to wait forever
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - Others Error of the last attempt
+ */
+esp_err_t i2c_health_transmit(i2c_health_dev_handle_t dev, const uint8_t *data, size_t len, int timeout_ms);
+
+/**
+ * @brief Read from the device, retrying on failure
+ *
+ * @param dev        device handle
+ * @param data       buffer for the received bytes
+ * @param len        number of bytes
+ * @param timeout_ms timeout of each attempt, -1 to wait forever
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - Others Error of the last attempt
+ */
+esp_err_t i2c_health_receive(i2c_health_dev_handle_t dev, uint8_t *data, size_t len, int timeout_ms);
+
+/**
+ * @brief Write then read with a repeated start, retrying on failure
+ *
+ * @param dev        device handle
+ * @param tx         bytes to send
+ * @param tx_len     number of bytes to send
+ * @param rx         buffer for the received bytes
+ * @param rx_len     number of bytes to receive
+ * @param timeout_ms timeout of each attempt, -1 to wait forever
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - Others Error of the last attempt
+ */
+esp_err_t i2c_health_transmit_receive(i2c_health_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                                      uint8_t *rx, size_t rx_len, int timeout_ms);
+
+/**
+ * @brief Get a snapshot of the device counters
+ *
+ * @param dev   device handle
+ * @param stats copy of the counters
+ */
+void i2c_health_get_stats(i2c_health_dev_handle_t dev, i2c_health_stats_t *stats);
+
+/**
+ * @brief Zero the device counters
+ *
+ * @param dev device handle
+ */
+void i2c_health_reset_stats(i2c_health_dev_handle_t dev);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,703 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "nvs_flash.h"
+#include "icm42670.h"
+#include "icm42670_ahrs.h"
+#include "icm42670_calib.h"
+#include "icm42670_fusion.h"
+
+#define TRACE_SWING         TRACE_DIR "/tilt_swing.csv"     /* 100 Hz, pitch within +/-25 degrees */
+#define TRACE_STEEP         TRACE_DIR "/tilt_steep.csv"     /* 400 Hz, pitch up to 89 degrees */
+#define TRACE_MAX_ROWS      4000
+#define SETTLE_SECONDS      2           /* For the gyroscope bias to be worked off */
+#define TILT_ERROR_MAX_DEG  2.0f
+#define STEEP_PITCH_DEG     85.0f
+#define LINEAR_ACCE_MAX_G   0.05f       /* Tilt error plus accelerometer noise, on a trace without any */
+#define ATAN2_STEPS         100000
+#define ATAN2_ERROR_MAX_DEG 0.001
+
+/* Registers the driver tests look at on the simulated sensor */
+#define REG_PWR_MGMT0       0x1F
+#define REG_GYRO_CONFIG0    0x20
+#define REG_ACCEL_CONFIG0   0x21
+#define REG_APEX_CONFIG0    0x25
+#define REG_APEX_CONFIG1    0x26
+#define MREG1_FIFO_CONFIG5  0x01
+#define FIFO_PACKETS        8
+#define FIFO_HEADER         0x68        /* Accelerometer, gyroscope and timestamp present */
+#define CALIB_ACCE_LSB_G    8192.0f     /* ACCE_FS_4G */
+#define CALIB_GYRO_LSB_DPS  131.0f      /* GYRO_FS_250DPS */
+#define CALIB_SAMPLES       4
+#define CALIB_TOLERANCE     1e-3f
+#define CALIB_TEST_KEY      "calib_test"
+
+#define DEG_TO_RAD          0.01745329252f
+#define RAD_TO_DEG          57.29577951f
+
+typedef struct {
+    float tilt;                 /* Worst gravity error after settling, degrees */
+    float tilt_steep;           /* The same, over rows pitched past STEEP_PITCH_DEG */
+    float linear;               /* Largest linear acceleration reported, g */
+} replay_result_t;
+
+typedef struct {
+    icm42670_fusion_sample_t sample;
+    float roll;                 /* Ground truth, degrees */
+    float pitch;
+} trace_row_t;
+
+static trace_row_t s_trace[TRACE_MAX_ROWS];
+static size_t s_trace_rows;
+static icm42670_sim_handle_t s_sim;
+static icm42670_handle_t s_sensor;
+
+/* Rows of the CSV written by traces/make_tilt_trace.py; header lines are skipped */
+static void trace_load(const char *path)
+{
+    char line[160];
+    FILE *file = fopen(path, "r");
+
+    TEST_ASSERT_NOT_NULL_MESSAGE(file, path);
+    s_trace_rows = 0;
+    while (fgets(line, sizeof(line), file) && s_trace_rows < TRACE_MAX_ROWS) {
+        trace_row_t *row = &s_trace[s_trace_rows];
+        unsigned long t_us;
+        if (sscanf(line, "%lu,%f,%f,%f,%f,%f,%f,%f,%f", &t_us,
+                   &row->sample.acce.x, &row->sample.acce.y, &row->sample.acce.z,
+                   &row->sample.gyro.x, &row->sample.gyro.y, &row->sample.gyro.z,
+                   &row->roll, &row->pitch) == 9) {
+            row->sample.timestamp_us = (uint32_t) t_us;
+            s_trace_rows++;
+        }
+    }
+    fclose(file);
+    TEST_ASSERT_GREATER_THAN(0, s_trace_rows);
+}
+
+static float vector_norm(const icm42670_value_t *v)
+{
+    return sqrtf(v->x * v->x + v->y * v->y + v->z * v->z);
+}
+
+/* Angle between the estimated gravity direction and the true one */
+static float tilt_error_deg(const icm42670_value_t *gravity, const trace_row_t *row)
+{
+    float roll = row->roll * DEG_TO_RAD;
+    float pitch = row->pitch * DEG_TO_RAD;
+    float dot = -sinf(pitch) * gravity->x +
+                sinf(roll) * cosf(pitch) * gravity->y +
+                cosf(roll) * cosf(pitch) * gravity->z;
+    float norm = vector_norm(gravity);
+
+    return acosf(fminf(dot / norm, 1.0f)) * RAD_TO_DEG;
+}
+
+/* Difference of two angles on the circle, so 180 and -180 agree */
+static double angle_diff_deg(double a, double b)
+{
+    double diff = fmod(fabs(a - b), 360.0);
+
+    return diff > 180.0 ? 360.0 - diff : diff;
+}
+
+/* Gyroscope only after the first sample, so the angle is the integral of the rate */
+static icm42670_fusion_handle_t fusion_open(uint8_t timestamp_bits, uint32_t max_gap_us)
+{
+    icm42670_fusion_config_t config = ICM42670_FUSION_CONFIG_DEFAULT();
+    icm42670_fusion_handle_t filter;
+
+    config.alpha = 1.0f;
+    config.timestamp_bits = timestamp_bits;
+    config.max_gap_us = max_gap_us;
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fusion_create(&config, &filter));
+    return filter;
+}
+
+/* One flat sample turning about x at roll_dps */
+static float fusion_feed(icm42670_fusion_handle_t filter, uint32_t timestamp_us, float roll_dps)
+{
+    const icm42670_fusion_sample_t sample = {
+        .acce = {0.0f, 0.0f, 1.0f},
+        .gyro = {roll_dps, 0.0f, 0.0f},
+        .timestamp_us = timestamp_us,
+    };
+    complimentary_angle_t angle;
+
+    icm42670_fusion_update(filter, &sample, 1, &angle);
+    return angle.roll;
+}
+
+static replay_result_t ahrs_replay(icm42670_ahrs_algorithm_t algorithm, float rate_hz)
+{
+    icm42670_ahrs_config_t config = ICM42670_AHRS_CONFIG_DEFAULT();
+    icm42670_ahrs_handle_t ahrs;
+    icm42670_value_t gravity;
+    icm42670_value_t linear;
+    replay_result_t worst = {0};
+    size_t settle = (size_t) (rate_hz * SETTLE_SECONDS);
+
+    config.algorithm = algorithm;
+    config.sample_rate_hz = rate_hz;
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_ahrs_create(&config, &ahrs));
+    TEST_ASSERT_GREATER_THAN(settle, s_trace_rows);
+
+    for (size_t i = 0; i < s_trace_rows; i++) {
+        icm42670_ahrs_update(ahrs, &s_trace[i].sample.acce, &s_trace[i].sample.gyro);
+        if (i < settle) {
+            continue;
+        }
+        icm42670_ahrs_get_gravity(ahrs, &gravity);
+        icm42670_ahrs_get_linear_acce(ahrs, &linear);
+        float tilt = tilt_error_deg(&gravity, &s_trace[i]);
+        worst.tilt = fmaxf(worst.tilt, tilt);
+        if (fabsf(s_trace[i].pitch) >= STEEP_PITCH_DEG) {
+            worst.tilt_steep = fmaxf(worst.tilt_steep, tilt);
+        }
+        worst.linear = fmaxf(worst.linear, vector_norm(&linear));
+    }
+
+    icm42670_ahrs_delete(ahrs);
+    printf("%s at %.0f Hz: worst tilt error %.2f deg, %.2f deg past %.0f deg pitch, linear %.3f g\n",
+           algorithm == ICM42670_AHRS_MADGWICK ? "Madgwick" : "Mahony", rate_hz,
+           worst.tilt, worst.tilt_steep, STEEP_PITCH_DEG, worst.linear);
+    return worst;
+}
+
+static void assert_tracks_swing(icm42670_ahrs_algorithm_t algorithm)
+{
+    trace_load(TRACE_SWING);
+    replay_result_t worst = ahrs_replay(algorithm, 100.0f);
+    TEST_ASSERT_LESS_THAN_FLOAT(TILT_ERROR_MAX_DEG, worst.tilt);
+    TEST_ASSERT_LESS_THAN_FLOAT(LINEAR_ACCE_MAX_G, worst.linear);
+}
+
+/* Near vertical, where roll and pitch fold into each other */
+static void assert_tracks_steep(icm42670_ahrs_algorithm_t algorithm)
+{
+    trace_load(TRACE_STEEP);
+    replay_result_t worst = ahrs_replay(algorithm, 400.0f);
+    TEST_ASSERT_GREATER_THAN(0.0f, worst.tilt_steep);      // The trace did get there
+    TEST_ASSERT_LESS_THAN_FLOAT(TILT_ERROR_MAX_DEG, worst.tilt_steep);
+    TEST_ASSERT_LESS_THAN_FLOAT(TILT_ERROR_MAX_DEG, worst.tilt);
+    TEST_ASSERT_LESS_THAN_FLOAT(LINEAR_ACCE_MAX_G, worst.linear);
+}
+
+TEST_CASE("Madgwick tracks the tilt of the recorded swing", "[icm42670][ahrs]")
+{
+    assert_tracks_swing(ICM42670_AHRS_MADGWICK);
+}
+
+TEST_CASE("Mahony tracks the tilt of the recorded swing", "[icm42670][ahrs]")
+{
+    assert_tracks_swing(ICM42670_AHRS_MAHONY);
+}
+
+TEST_CASE("Madgwick tracks a pitch up to near vertical at 400 Hz", "[icm42670][ahrs]")
+{
+    assert_tracks_steep(ICM42670_AHRS_MADGWICK);
+}
+
+TEST_CASE("Mahony tracks a pitch up to near vertical at 400 Hz", "[icm42670][ahrs]")
+{
+    assert_tracks_steep(ICM42670_AHRS_MAHONY);
+}
+
+TEST_CASE("a still, flat board reads level, and a push on it reads as linear acceleration", "[icm42670][ahrs]")
+{
+    const icm42670_value_t acce = {0.0f, 0.0f, 1.0f};
+    const icm42670_value_t pushed = {0.3f, -0.2f, 1.0f};
+    const icm42670_value_t gyro = {0.0f, 0.0f, 0.0f};
+    icm42670_value_t linear;
+    icm42670_ahrs_config_t config = ICM42670_AHRS_CONFIG_DEFAULT();
+    icm42670_ahrs_handle_t ahrs;
+    icm42670_euler_t euler;
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_ahrs_create(&config, &ahrs));
+    for (int i = 0; i < 100; i++) {
+        icm42670_ahrs_update(ahrs, &acce, &gyro);
+    }
+    icm42670_ahrs_get_euler(ahrs, &euler);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, euler.roll);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, euler.pitch);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, euler.yaw);
+
+    // One sample is too short to tip the estimate, so the push comes out whole
+    icm42670_ahrs_update(ahrs, &pushed, &gyro);
+    icm42670_ahrs_get_linear_acce(ahrs, &linear);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.3f, linear.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -0.2f, linear.y);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, linear.z);
+    icm42670_ahrs_delete(ahrs);
+}
+
+TEST_CASE("max_gap_us must fit in the timestamp width", "[icm42670][fusion]")
+{
+    icm42670_fusion_config_t config = ICM42670_FUSION_CONFIG_DEFAULT();
+    icm42670_fusion_handle_t filter = NULL;
+
+    config.timestamp_bits = 16;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, icm42670_fusion_create(&config, &filter));
+    TEST_ASSERT_NULL(filter);
+
+    config.max_gap_us = UINT16_MAX;
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fusion_create(&config, &filter));
+    icm42670_fusion_delete(filter);
+}
+
+TEST_CASE("dt comes from the sample timestamps", "[icm42670][fusion]")
+{
+    icm42670_fusion_handle_t filter = fusion_open(32, 100000);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, fusion_feed(filter, 1000000, 100.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f, fusion_feed(filter, 1005000, 100.0f));    // 5 ms
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.5f, fusion_feed(filter, 1025000, 100.0f));    // 20 ms
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.5f, fusion_feed(filter, 1035000, -100.0f));   // 10 ms back
+    icm42670_fusion_delete(filter);
+}
+
+TEST_CASE("16-bit timestamps wrap without a jump in dt", "[icm42670][fusion]")
+{
+    icm42670_fusion_handle_t filter = fusion_open(16, UINT16_MAX);
+
+    fusion_feed(filter, 60000, 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, fusion_feed(filter, (60000 + 10000) & UINT16_MAX, 100.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, fusion_feed(filter, (60000 + 20000) & UINT16_MAX, 100.0f));
+    icm42670_fusion_delete(filter);
+}
+
+TEST_CASE("a sample seen twice is only counted once", "[icm42670][fusion]")
+{
+    icm42670_fusion_handle_t filter = fusion_open(32, 100000);
+
+    fusion_feed(filter, 1000, 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, fusion_feed(filter, 11000, 100.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, fusion_feed(filter, 11000, 100.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, fusion_feed(filter, 21000, 100.0f));
+    icm42670_fusion_delete(filter);
+}
+
+TEST_CASE("a gap past max_gap_us restarts from the accelerometer", "[icm42670][fusion]")
+{
+    const icm42670_fusion_sample_t tilted = {
+        .acce = {0.0f, 0.5f, 0.8660254f},       // 30 degrees of roll
+        .gyro = {100.0f, 0.0f, 0.0f},
+        .timestamp_us = 100001,                 // One microsecond past the gap below
+    };
+    icm42670_fusion_handle_t filter = fusion_open(32, 50000);
+    complimentary_angle_t angle;
+
+    // The longest gap allowed is still bridged by the gyroscope
+    fusion_feed(filter, 0, 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 5.0f, fusion_feed(filter, 50000, 100.0f));
+
+    // One microsecond more and the accelerometer wins outright
+    icm42670_fusion_update(filter, &tilted, 1, &angle);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 30.0f, angle.roll);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, angle.pitch);
+
+    // And integration carries on from there
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 31.0f, fusion_feed(filter, 110001, 100.0f));
+    icm42670_fusion_delete(filter);
+}
+
+TEST_CASE("fast atan2 stays within 0.001 degrees over the circle", "[icm42670][fusion]")
+{
+    static const float radii[] = {1e-3f, 1.0f, 1e3f};
+    double worst = 0.0;
+
+    for (size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+        for (int i = -ATAN2_STEPS; i <= ATAN2_STEPS; i++) {
+            double t = i * M_PI / ATAN2_STEPS;
+            float y = radii[r] * sin(t);
+            float x = radii[r] * cos(t);
+            worst = fmax(worst, angle_diff_deg(icm42670_fast_atan2_deg(y, x), atan2(y, x) * RAD_TO_DEG));
+        }
+    }
+    printf("icm42670_fast_atan2_deg: worst error %.5f deg\n", worst);
+    TEST_ASSERT_TRUE(worst < ATAN2_ERROR_MAX_DEG);
+
+    // Axes, either sign of zero on the other one
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, icm42670_fast_atan2_deg(0.0f, 1.0f));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, icm42670_fast_atan2_deg(-0.0f, 1.0f));
+    TEST_ASSERT_EQUAL_FLOAT(90.0f, icm42670_fast_atan2_deg(1.0f, 0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(90.0f, icm42670_fast_atan2_deg(1.0f, -0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(-90.0f, icm42670_fast_atan2_deg(-1.0f, 0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(-90.0f, icm42670_fast_atan2_deg(-1.0f, -0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(180.0f, fabsf(icm42670_fast_atan2_deg(0.0f, -1.0f)));
+    TEST_ASSERT_EQUAL_FLOAT(180.0f, fabsf(icm42670_fast_atan2_deg(-0.0f, -1.0f)));
+    TEST_ASSERT_FLOAT_WITHIN(ATAN2_ERROR_MAX_DEG, 45.0f, icm42670_fast_atan2_deg(1.0f, 1.0f));
+    TEST_ASSERT_FLOAT_WITHIN(ATAN2_ERROR_MAX_DEG, -135.0f, icm42670_fast_atan2_deg(-1.0f, -1.0f));
+
+    // No direction at all
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, icm42670_fast_atan2_deg(0.0f, 0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, icm42670_fast_atan2_deg(-0.0f, -0.0f));
+}
+
+static void sensor_open(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_sim_create(&s_sim));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_create(s_sim, ICM42670_I2C_ADDRESS, &s_sensor));
+    icm42670_sim_reset_stats(s_sim);
+}
+
+static void sensor_close(void)
+{
+    icm42670_delete(s_sensor);
+    icm42670_sim_delete(s_sim);
+}
+
+/* Bus traffic since the last call */
+static icm42670_sim_stats_t take_stats(void)
+{
+    icm42670_sim_stats_t stats;
+
+    icm42670_sim_get_stats(s_sim, &stats);
+    icm42670_sim_reset_stats(s_sim);
+    return stats;
+}
+
+static void put_be16(uint8_t *out, int16_t value)
+{
+    out[0] = (uint16_t) value >> 8;
+    out[1] = (uint16_t) value & 0xFF;
+}
+
+/* Packet i of a 16-byte accelerometer + gyroscope stream, laid out as in the datasheet */
+static void make_packet(uint8_t packet[16], int i)
+{
+    packet[0] = FIFO_HEADER;
+    for (int axis = 0; axis < 3; axis++) {
+        put_be16(&packet[1 + 2 * axis], (int16_t)(1000 * i + axis - 2000));
+        put_be16(&packet[7 + 2 * axis], (int16_t)(-100 * i - axis));
+    }
+    packet[13] = (uint8_t)(int8_t)(i - 4);
+    put_be16(&packet[14], (int16_t)(65000 + 1000 * i));     // Wraps past the fifth packet
+}
+
+static void assert_packet(const icm42670_fifo_sample_t *sample, int i)
+{
+    TEST_ASSERT_EQUAL(FIFO_HEADER, sample->header);
+    TEST_ASSERT_EQUAL(1000 * i - 2000, sample->acce.x);
+    TEST_ASSERT_EQUAL(1000 * i - 1999, sample->acce.y);
+    TEST_ASSERT_EQUAL(1000 * i - 1998, sample->acce.z);
+    TEST_ASSERT_EQUAL(-100 * i, sample->gyro.x);
+    TEST_ASSERT_EQUAL(-100 * i - 1, sample->gyro.y);
+    TEST_ASSERT_EQUAL(-100 * i - 2, sample->gyro.z);
+    TEST_ASSERT_EQUAL((i - 4) * 64, sample->temp);
+    TEST_ASSERT_EQUAL((uint16_t)(65000 + 1000 * i), sample->timestamp);
+}
+
+TEST_CASE("turning the sensors off clears the low-noise mode bits", "[icm42670][driver]")
+{
+    icm42670_sim_create(&s_sim);
+    icm42670_sim_set_reg(s_sim, REG_PWR_MGMT0, 0x80);  // ACCEL_LP_CLK_SEL, not the driver's to touch
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_create(s_sim, ICM42670_I2C_ADDRESS, &s_sensor));
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_acce_set_pwr(s_sensor, ACCE_PWR_LOWNOISE));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_gyro_set_pwr(s_sensor, GYRO_PWR_LOWNOISE));
+    TEST_ASSERT_EQUAL(0x8F, icm42670_sim_get_reg(s_sim, REG_PWR_MGMT0));
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_acce_set_pwr(s_sensor, ACCE_PWR_OFF));
+    TEST_ASSERT_EQUAL(0x8C, icm42670_sim_get_reg(s_sim, REG_PWR_MGMT0));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_gyro_set_pwr(s_sensor, GYRO_PWR_OFF));
+    TEST_ASSERT_EQUAL(0x80, icm42670_sim_get_reg(s_sim, REG_PWR_MGMT0));
+    sensor_close();
+}
+
+TEST_CASE("repeating a configuration sends nothing, a change only the registers that differ", "[icm42670][driver]")
+{
+    icm42670_cfg_t config = {
+        .acce_fs = ACCE_FS_4G,
+        .acce_odr = ACCE_ODR_100HZ,
+        .gyro_fs = GYRO_FS_500DPS,
+        .gyro_odr = GYRO_ODR_100HZ,
+    };
+    float sensitivity;
+
+    sensor_open();
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &config));
+    TEST_ASSERT_EQUAL(1, take_stats().transactions);
+    TEST_ASSERT_EQUAL(0x49, icm42670_sim_get_reg(s_sim, REG_GYRO_CONFIG0));
+    TEST_ASSERT_EQUAL(0x49, icm42670_sim_get_reg(s_sim, REG_ACCEL_CONFIG0));
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &config));
+    TEST_ASSERT_EQUAL(0, take_stats().transactions);
+
+    config.acce_fs = ACCE_FS_2G;
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &config));
+    icm42670_sim_stats_t stats = take_stats();
+    TEST_ASSERT_EQUAL(1, stats.transactions);
+    TEST_ASSERT_EQUAL(2, stats.bytes_written);     // ACCEL_CONFIG0 alone: address, value
+    TEST_ASSERT_EQUAL(0x69, icm42670_sim_get_reg(s_sim, REG_ACCEL_CONFIG0));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_get_acce_sensitivity(s_sensor, &sensitivity));
+    TEST_ASSERT_EQUAL_FLOAT(16384.0f, sensitivity);
+    sensor_close();
+}
+
+TEST_CASE("after a NACKed write the registers are sent again, even with the values they had", "[icm42670][driver]")
+{
+    const icm42670_cfg_t before = {
+        .acce_fs = ACCE_FS_8G,
+        .acce_odr = ACCE_ODR_50HZ,
+        .gyro_fs = GYRO_FS_1000DPS,
+        .gyro_odr = GYRO_ODR_50HZ,
+    };
+    icm42670_cfg_t failed = before;
+
+    sensor_open();
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &before));
+
+    // The sensor may or may not have taken a write that failed, so the shadow can't vouch for either value
+    failed.gyro_odr = GYRO_ODR_400HZ;
+    icm42670_sim_inject_nack(s_sim, 1);
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, icm42670_config(s_sensor, &failed));
+    take_stats();
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &before));
+    TEST_ASSERT_EQUAL(1, take_stats().transactions);
+    TEST_ASSERT_EQUAL(0x2A, icm42670_sim_get_reg(s_sim, REG_GYRO_CONFIG0));
+    TEST_ASSERT_EQUAL(0x2A, icm42670_sim_get_reg(s_sim, REG_ACCEL_CONFIG0));
+    sensor_close();
+}
+
+TEST_CASE("fifo_read decodes packets in place, oldest first", "[icm42670][driver]")
+{
+    const icm42670_fifo_cfg_t fifo = {.packet = ICM42670_FIFO_PACKET_ACCEL_GYRO};
+    icm42670_fifo_sample_t samples[FIFO_PACKETS];
+    uint8_t packet[16];
+    size_t count;
+
+    sensor_open();
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_config(s_sensor, &fifo));
+    for (int i = 0; i < FIFO_PACKETS; i++) {
+        make_packet(packet, i);
+        TEST_ASSERT_EQUAL(ESP_OK, icm42670_sim_fifo_push(s_sim, packet, sizeof(packet)));
+    }
+    take_stats();
+
+    // The whole FIFO in two transfers, count and data, each packet decoded over the raw bytes
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_read(s_sensor, samples, FIFO_PACKETS, &count));
+    TEST_ASSERT_EQUAL(FIFO_PACKETS, count);
+    TEST_ASSERT_EQUAL(2, take_stats().transactions);
+    for (int i = 0; i < FIFO_PACKETS; i++) {
+        assert_packet(&samples[i], i);
+    }
+
+    // No more than asked for; the rest stays for the next read
+    for (int i = 0; i < FIFO_PACKETS; i++) {
+        make_packet(packet, i);
+        icm42670_sim_fifo_push(s_sim, packet, sizeof(packet));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_read(s_sensor, samples, 3, &count));
+    TEST_ASSERT_EQUAL(3, count);
+    assert_packet(&samples[2], 2);
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_read(s_sensor, samples, FIFO_PACKETS, &count));
+    TEST_ASSERT_EQUAL(FIFO_PACKETS - 3, count);
+    assert_packet(&samples[0], 3);
+
+    // Stops at a packet flagged empty
+    make_packet(packet, 0);
+    icm42670_sim_fifo_push(s_sim, packet, sizeof(packet));
+    packet[0] = 0x80;
+    icm42670_sim_fifo_push(s_sim, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_read(s_sensor, samples, FIFO_PACKETS, &count));
+    TEST_ASSERT_EQUAL(1, count);
+    sensor_close();
+}
+
+TEST_CASE("an accelerometer-only FIFO is set up with the sensors off and reads without gyroscope", "[icm42670][driver]")
+{
+    const icm42670_fifo_cfg_t fifo = {.packet = ICM42670_FIFO_PACKET_ACCEL};
+    const uint8_t packet[8] = {0x40, 0x01, 0x02, 0xFF, 0xFE, 0x40, 0x00, 0x32};
+    icm42670_fifo_sample_t sample;
+    size_t count;
+
+    sensor_open();
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_config(s_sensor, &fifo));
+
+    // FIFO_CONFIG5 only lands with MCLK running, so IDLE was held for it and released
+    TEST_ASSERT_EQUAL(0x21, icm42670_sim_get_mreg1(s_sim, MREG1_FIFO_CONFIG5));
+    TEST_ASSERT_EQUAL(0x00, icm42670_sim_get_reg(s_sim, REG_PWR_MGMT0));
+
+    icm42670_sim_fifo_push(s_sim, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_fifo_read(s_sensor, &sample, 1, &count));
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(0x0102, sample.acce.x);
+    TEST_ASSERT_EQUAL(-2, sample.acce.y);
+    TEST_ASSERT_EQUAL(0x4000, sample.acce.z);
+    TEST_ASSERT_EQUAL(ICM42670_FIFO_INVALID, sample.gyro.x);
+    TEST_ASSERT_EQUAL(50 * 64, sample.temp);
+    TEST_ASSERT_EQUAL(0, sample.timestamp);
+    sensor_close();
+}
+
+TEST_CASE("starting tilt detection keeps the other APEX_CONFIG0 bits", "[icm42670][driver]")
+{
+    const icm42670_cfg_t config = {
+        .acce_fs = ACCE_FS_2G,
+        .acce_odr = ACCE_ODR_50HZ,
+        .gyro_fs = GYRO_FS_2000DPS,
+        .gyro_odr = GYRO_ODR_50HZ,
+    };
+    const icm42670_apex_cfg_t apex = {.features = ICM42670_APEX_TILT};
+
+    sensor_open();
+    TEST_ASSERT_EQUAL(0x08, icm42670_sim_get_reg(s_sim, REG_APEX_CONFIG0));     // DMP_POWER_SAVE_EN
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &config));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_acce_set_pwr(s_sensor, ACCE_PWR_LOWNOISE));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_apex_config(s_sensor, &apex));
+
+    TEST_ASSERT_EQUAL(0x08, icm42670_sim_get_reg(s_sim, REG_APEX_CONFIG0));
+    TEST_ASSERT_EQUAL(0xB2, icm42670_sim_get_reg(s_sim, REG_APEX_CONFIG1));     // Tilt on, DMP at 50 Hz
+    sensor_close();
+}
+
+/* Sensor on at 4 g and 250 dps, as the labs calibrate it */
+static void calib_open(bool gyro_on)
+{
+    const icm42670_cfg_t config = {
+        .acce_fs = ACCE_FS_4G,
+        .acce_odr = ACCE_ODR_100HZ,
+        .gyro_fs = GYRO_FS_250DPS,
+        .gyro_odr = GYRO_ODR_100HZ,
+    };
+
+    sensor_open();
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_config(s_sensor, &config));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_acce_set_pwr(s_sensor, ACCE_PWR_LOWNOISE));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_gyro_set_pwr(s_sensor, gyro_on ? GYRO_PWR_LOWNOISE : GYRO_PWR_OFF));
+}
+
+/* A still board reading acce in g and gyro in dps */
+static void calib_hold(const icm42670_value_t *acce, const icm42670_value_t *gyro)
+{
+    const icm42670_all_raw_value_t raw = {
+        .acce = {lroundf(acce->x * CALIB_ACCE_LSB_G), lroundf(acce->y * CALIB_ACCE_LSB_G), lroundf(acce->z * CALIB_ACCE_LSB_G)},
+        .gyro = {lroundf(gyro->x * CALIB_GYRO_LSB_DPS), lroundf(gyro->y * CALIB_GYRO_LSB_DPS), lroundf(gyro->z * CALIB_GYRO_LSB_DPS)},
+    };
+
+    icm42670_sim_set_data(s_sim, &raw);
+}
+
+static void assert_value(float x, float y, float z, const icm42670_value_t *value)
+{
+    TEST_ASSERT_FLOAT_WITHIN(CALIB_TOLERANCE, x, value->x);
+    TEST_ASSERT_FLOAT_WITHIN(CALIB_TOLERANCE, y, value->y);
+    TEST_ASSERT_FLOAT_WITHIN(CALIB_TOLERANCE, z, value->z);
+}
+
+TEST_CASE("bias estimated on a still, flat board cancels out of the readings", "[icm42670][calib]")
+{
+    const icm42670_value_t acce = {0.01f, -0.005f, 1.02f};
+    const icm42670_value_t gyro = {1.0f, -2.0f, 0.1f};
+    icm42670_calib_t calib = ICM42670_CALIB_DEFAULT();
+    icm42670_value_t value;
+
+    calib_open(true);
+    calib_hold(&acce, &gyro);
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_calib_estimate_bias(s_sensor, CALIB_SAMPLES, 0, &calib));
+    assert_value(0.01f, -0.005f, 0.02f, &calib.acce_bias);
+    assert_value(1.0f, -2.0f, 0.1f, &calib.gyro_bias);
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_set_calibration(s_sensor, &calib));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_get_acce_value(s_sensor, &value));
+    assert_value(0.0f, 0.0f, 1.0f, &value);
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_get_gyro_value(s_sensor, &value));
+    assert_value(0.0f, 0.0f, 0.0f, &value);
+    sensor_close();
+}
+
+TEST_CASE("bias estimation skips a gyroscope that is off and refuses an accelerometer that is", "[icm42670][calib]")
+{
+    const icm42670_value_t acce = {0.0f, 0.0f, 1.0f};
+    const icm42670_value_t gyro = {5.0f, 5.0f, 5.0f};
+    icm42670_calib_t calib = ICM42670_CALIB_DEFAULT();
+
+    calib_open(false);
+    calib_hold(&acce, &gyro);
+    calib.gyro_bias = (icm42670_value_t) {0.5f, 0.5f, 0.5f};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, icm42670_calib_estimate_bias(s_sensor, 0, 0, &calib));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_calib_estimate_bias(s_sensor, CALIB_SAMPLES, 0, &calib));
+    assert_value(0.5f, 0.5f, 0.5f, &calib.gyro_bias);
+
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_acce_set_pwr(s_sensor, ACCE_PWR_OFF));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, icm42670_calib_estimate_bias(s_sensor, CALIB_SAMPLES, 0, &calib));
+    sensor_close();
+}
+
+TEST_CASE("six positions give back the scale and bias of each axis", "[icm42670][calib]")
+{
+    const float scale[3] = {1.02f, 0.98f, 1.01f};
+    const float bias[3] = {0.01f, -0.02f, 0.03f};
+    const icm42670_value_t still = {0.0f, 0.0f, 0.0f};
+    const icm42670_value_t askew = {0.7f, 0.7f, 0.1f};
+    icm42670_calib_six_pos_t state = {0};
+    icm42670_calib_t calib = ICM42670_CALIB_DEFAULT();
+    icm42670_value_t value;
+
+    calib_open(false);
+
+    // Square to no axis
+    calib_hold(&askew, &still);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, icm42670_calib_six_pos_capture(s_sensor, &state, CALIB_SAMPLES, 0));
+
+    // Each axis up then down; a reading is (+/-1 g) / scale + bias, the other axes bias alone
+    for (int axis = 0; axis < 3; axis++) {
+        for (int dir = 1; dir >= -1; dir -= 2) {
+            float reading[3] = {bias[0], bias[1], bias[2]};
+            reading[axis] += dir / scale[axis];
+            icm42670_value_t acce = {reading[0], reading[1], reading[2]};
+
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, icm42670_calib_six_pos_finish(&state, &calib));
+            calib_hold(&acce, &still);
+            TEST_ASSERT_EQUAL(ESP_OK, icm42670_calib_six_pos_capture(s_sensor, &state, CALIB_SAMPLES, 0));
+        }
+    }
+    TEST_ASSERT_TRUE(icm42670_calib_six_pos_done(&state));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_calib_six_pos_finish(&state, &calib));
+    assert_value(scale[0], scale[1], scale[2], &calib.acce_scale);
+    assert_value(bias[0], bias[1], bias[2], &calib.acce_bias);
+
+    // Applied, the last position (Z down) reads a clean -1 g
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_set_calibration(s_sensor, &calib));
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_get_acce_value(s_sensor, &value));
+    assert_value(0.0f, 0.0f, -1.0f, &value);
+    sensor_close();
+}
+
+TEST_CASE("calibration is estimated and stored on first boot, then loaded", "[icm42670][calib]")
+{
+    const icm42670_value_t acce = {0.02f, 0.0f, 1.0f};
+    const icm42670_value_t moved = {0.3f, 0.0f, 0.95f};
+    const icm42670_value_t gyro = {0.0f, 0.0f, 0.0f};
+    icm42670_calib_t calib;
+    icm42670_calib_t applied;
+
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_flash_erase());
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_flash_init());
+
+    calib_open(true);
+    calib_hold(&acce, &gyro);
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_calib_load_or_estimate(s_sensor, CALIB_TEST_KEY, CALIB_SAMPLES, 0, &calib));
+    assert_value(0.02f, 0.0f, 0.0f, &calib.acce_bias);
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_get_calibration(s_sensor, &applied));
+    TEST_ASSERT_EQUAL_MEMORY(&calib, &applied, sizeof(calib));
+    sensor_close();
+
+    // Next boot: whatever the board reads now, the stored bias is used
+    calib_open(true);
+    calib_hold(&moved, &gyro);
+    TEST_ASSERT_EQUAL(ESP_OK, icm42670_calib_load_or_estimate(s_sensor, CALIB_TEST_KEY, CALIB_SAMPLES, 0, &applied));
+    TEST_ASSERT_EQUAL_MEMORY(&calib, &applied, sizeof(calib));
+    sensor_close();
+    nvs_flash_deinit();
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
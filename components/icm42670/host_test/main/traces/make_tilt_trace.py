@@ -0,0 +1,62 @@
+"""Write a synthetic ICM42670 trace with its ground truth.
+
+Yaw is held at 0 while roll and pitch move. Each row is what the driver would
+return, plus the true angles the samples came from. Readings get a fixed
+gyroscope bias and Gaussian noise of about the datasheet level, from a fixed
+seed so the files are reproducible:
+
+    python make_tilt_trace.py swing > tilt_swing.csv
+    python make_tilt_trace.py steep > tilt_steep.csv
+
+swing: 100 Hz, roll and pitch swing at once, pitch within +/-25 degrees.
+steep: 400 Hz, pitch climbs from level to 89 degrees and back, twice, under
+a small roll swing, so both filters pass close to vertical.
+"""
+import math
+import random
+import sys
+
+PROFILES = {
+    # rate_hz, seconds, (roll offset, amplitude, Hz, phase), (pitch ...)
+    'swing': (100, 12, (0.0, 40.0, 0.25, 0.0), (0.0, 25.0, 0.4, 1.0)),
+    'steep': (400, 8, (0.0, 10.0, 0.3, 0.0), (44.5, 44.5, 0.25, -math.pi / 2)),
+}
+GYRO_BIAS_DPS = (0.4, -0.3, 0.2)
+GYRO_NOISE_DPS = 0.07
+ACCE_NOISE_G = 0.005
+
+
+def wave(t, offset_deg, ampl_deg, hz, phase):
+    """Angle and its rate, in radians and rad/s."""
+    w = 2 * math.pi * hz
+    return (math.radians(offset_deg + ampl_deg * math.sin(w * t + phase)),
+            math.radians(ampl_deg) * w * math.cos(w * t + phase))
+
+
+def main():
+    rate_hz, seconds, roll_wave, pitch_wave = PROFILES[sys.argv[1] if len(sys.argv) > 1 else 'swing']
+    rng = random.Random(42670)
+    print('# synthetic, make_tilt_trace.py; acce in g, gyro in dps, truth in degrees')
+    print('t_us,ax,ay,az,gx,gy,gz,roll,pitch')
+    for n in range(rate_hz * seconds):
+        t = n / rate_hz
+        roll, roll_rate = wave(t, *roll_wave)
+        pitch, pitch_rate = wave(t, *pitch_wave)
+
+        # Gravity seen in the sensor frame, ZYX angles with yaw 0
+        acce = (-math.sin(pitch),
+                math.sin(roll) * math.cos(pitch),
+                math.cos(roll) * math.cos(pitch))
+        # Body rates from the Euler angle rates
+        gyro = (roll_rate,
+                pitch_rate * math.cos(roll),
+                -pitch_rate * math.sin(roll))
+
+        acce = [a + rng.gauss(0, ACCE_NOISE_G) for a in acce]
+        gyro = [math.degrees(g) + b + rng.gauss(0, GYRO_NOISE_DPS) for g, b in zip(gyro, GYRO_BIAS_DPS)]
+        print('%d,%.5f,%.5f,%.5f,%.4f,%.4f,%.4f,%.4f,%.4f' % (
+            n * 1000000 // rate_hz, *acce, *gyro, math.degrees(roll), math.degrees(pitch)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,1123 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+ #include <inttypes.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdio.h>
+ #include <math.h>
+ #include <time.h>
+ #include <sys/time.h>
+ #include "esp_attr.h"
+ #include "esp_check.h"
+ #include "esp_timer.h"
+ #include "freertos/task.h"
+ #include "icm42670.h"
+ #include "icm42670_port.h"
+ 
+ #define ALPHA                       0.99f        /*!< Weight of gyroscope */
+ #define RAD_TO_DEG                  57.27272727f /*!< Radians to degrees */
+ 
+ #define ICM42607_ID 0x60
+ #define ICM42670_ID 0x67
+ 
+ /* ICM42670 register */
+ #define ICM42670_MCLK_RDY       0x00
+ #define ICM42670_WHOAMI         0x75
+ #define ICM42670_GYRO_CONFIG0   0x20
+ #define ICM42670_ACCEL_CONFIG0  0x21
+ #define ICM42670_TEMP_CONFIG    0x22
+ #define ICM42670_PWR_MGMT0      0x1F
+ #define ICM42670_TEMP_DATA      0x09
+ #define ICM42670_ACCEL_DATA     0x0B
+ #define ICM42670_GYRO_DATA      0x11
+ #define ICM42670_SIGNAL_PATH_RESET 0x02
+ #define ICM42670_INT_CONFIG     0x06
+ #define ICM42670_FIFO_CONFIG1   0x28
+ #define ICM42670_FIFO_CONFIG2   0x29
+ #define ICM42670_APEX_CONFIG0   0x25
+ #define ICM42670_APEX_CONFIG1   0x26
+ #define ICM42670_WOM_CONFIG     0x27
+ #define ICM42670_INT_SOURCE0    0x2B
+ #define ICM42670_INT_SOURCE1    0x2C
+ #define ICM42670_APEX_DATA0     0x31
+ #define ICM42670_INTF_CONFIG0   0x35
+ #define ICM42670_INT_STATUS2    0x3B
+ #define ICM42670_FIFO_COUNTH    0x3D
+ #define ICM42670_FIFO_DATA      0x3F
+ #define ICM42670_BLK_SEL_W      0x79
+ 
+ /* Bank 0 configuration registers all sit below this address */
+ #define ICM42670_SHADOW_SIZE    0x37
+ 
+ /* MREG1 registers, reached through BLK_SEL_W/MADDR_W/M_W */
+ #define ICM42670_MREG1_FIFO_CONFIG5 0x01
+ #define ICM42670_MREG1_INT_SOURCE6  0x2F
+ #define ICM42670_MREG1_ACCEL_WOM_X_THR 0x4B
+ #define ICM42670_MREG_WRITE_DELAY_US 10
+ #define ICM42670_MCLK_RDY_POLLS 10     /* Reads of MCLK_RDY after setting IDLE, each ~50 us on the bus */
+ 
+ #define FIFO_FLUSH_BIT          (1 << 2)
+ #define FIFO_BYPASS_BIT         (1 << 0)
+ #define FIFO_STOP_ON_FULL_BIT   (1 << 1)
+ #define FIFO_COUNT_RECORDS_BIT  (1 << 6)
+ #define FIFO_WM_GT_TH_BIT       (1 << 5)
+ #define FIFO_GYRO_EN_BIT        (1 << 1)
+ #define FIFO_ACCEL_EN_BIT       (1 << 0)
+ #define FIFO_HEADER_EMPTY_BIT   (1 << 7)
+ #define FIFO_WATERMARK_MAX      0x0FFF
+ #define MCLK_RDY_BIT            (1 << 3)
+ #define PWR_IDLE_BIT            (1 << 4)
+ #define ACCEL_MODE_MASK         0x03
+ #define GYRO_MODE_MASK          0x0C
+ #define INT1_PUSH_PULL_BIT      (1 << 1)
+ #define INT1_ACTIVE_HIGH_BIT    (1 << 0)
+ #define DRDY_INT1_EN_BIT        (1 << 3)
+ #define FIFO_THS_INT1_EN_BIT    (1 << 2)
+ #define WOM_XYZ_INT1_EN_BITS    0x07        /* INT_SOURCE1 */
+ #define STEP_DET_INT1_EN_BIT    (1 << 5)    /* INT_SOURCE6 */
+ #define TILT_DET_INT1_EN_BIT    (1 << 3)
+ #define WOM_XYZ_INT_BITS        0x07        /* INT_STATUS2 */
+ #define STEP_DET_INT_BIT        (1 << 5)    /* INT_STATUS3 */
+ #define TILT_DET_INT_BIT        (1 << 3)
+ #define WOM_EN_BIT              (1 << 0)
+ #define WOM_MODE_PREVIOUS_BIT   (1 << 1)
+ #define DMP_MEM_RESET_BIT       (1 << 0)    /* APEX_CONFIG0, both self-clearing */
+ #define DMP_INIT_EN_BIT         (1 << 2)
+ #define PED_ENABLE_BIT          (1 << 3)    /* APEX_CONFIG1 */
+ #define TILT_ENABLE_BIT         (1 << 4)
+ #define DMP_ODR_MASK            0x03
+ #define APEX_ALL_FEATURES       (ICM42670_APEX_WOM | ICM42670_APEX_TILT | ICM42670_APEX_PEDOMETER)
+ #define DMP_RESET_DELAY_MS      1
+ #define DMP_INIT_DELAY_MS       50
+ #define WOM_THR_DELAY_MS        1
+ 
+ /* Sensitivity of the gyroscope */
+ #define GYRO_FS_2000_SENSITIVITY (16.4)
+ #define GYRO_FS_1000_SENSITIVITY (32.8)
+ #define GYRO_FS_500_SENSITIVITY  (65.5)
+ #define GYRO_FS_250_SENSITIVITY  (131.0)
+ 
+ /* Sensitivity of the accelerometer */
+ #define ACCE_FS_16G_SENSITIVITY (2048)
+ #define ACCE_FS_8G_SENSITIVITY  (4096)
+ #define ACCE_FS_4G_SENSITIVITY  (8192)
+ #define ACCE_FS_2G_SENSITIVITY  (16384)
+ 
+ /*******************************************************************************
+ * Types definitions
+ *******************************************************************************/
+ 
+ typedef struct {
+     icm42670_port_dev_t dev;   /*!< I2C device, or the simulated sensor on linux */
+     uint32_t counter;
+     float dt;  /*!< delay time between two measurements, dt should be small (ms level) */
+     struct timeval *timer;
+     icm42670_fifo_packet_t fifo_packet;
+     uint8_t fifo_packet_size;   /*!< Bytes per FIFO record, 0 while the FIFO is bypassed */
+     float acce_sensitivity;     /*!< LSB/g for the configured full-scale range */
+     float gyro_sensitivity;     /*!< LSB/dps for the configured full-scale range */
+     icm42670_calib_t calib;     /*!< Applied by every *_value read */
+     icm42670_value_t acce_gain;     /*!< calib.acce_scale / acce_sensitivity */
+     icm42670_value_t acce_offset;   /*!< calib.acce_bias * calib.acce_scale, in g */
+     float gyro_gain;                /*!< 1 / gyro_sensitivity */
+ #if !CONFIG_IDF_TARGET_LINUX
+     gpio_num_t int_gpio;        /*!< Pin on INT1, GPIO_NUM_NC while interrupts are off */
+     TaskHandle_t int_task;      /*!< Task blocked in icm42670_int_wait() */
+     int64_t int_timestamp;      /*!< esp_timer time of the latest INT1 pulse */
+     portMUX_TYPE int_lock;      /*!< Guards int_task and int_timestamp against the ISR */
+ #endif
+     uint8_t reg_shadow[ICM42670_SHADOW_SIZE];  /*!< Last value written to or read from each config register */
+     uint64_t reg_known;         /*!< Bit per register, set once reg_shadow holds it */
+     icm42670_int_source_t int_source;   /*!< What INT1 carries while int_gpio is set */
+     uint8_t apex_features;      /*!< ICM42670_APEX_* flags enabled by icm42670_apex_config() */
+     uint8_t int_source6;        /*!< Last value written to MREG1 INT_SOURCE6 */
+ } icm42670_dev_t;
+ 
+ /*******************************************************************************
+ * Function definitions
+ *******************************************************************************/
+ static esp_err_t icm42670_write(icm42670_handle_t sensor, const uint8_t reg_start_addr, const uint8_t *data_buf, const uint8_t data_len);
+ static esp_err_t icm42670_read(icm42670_handle_t sensor, const uint8_t reg_start_addr, uint8_t *data_buf, const size_t data_len);
+ static esp_err_t icm42670_write_mreg1(icm42670_handle_t sensor, const uint8_t reg, const uint8_t value);
+ static esp_err_t icm42670_write_shadowed(icm42670_handle_t sensor, const uint8_t reg_start_addr, const uint8_t *data_buf, const uint8_t data_len);
+ static esp_err_t icm42670_update_reg(icm42670_handle_t sensor, const uint8_t reg, const uint8_t mask, const uint8_t value);
+ static void icm42670_set_full_scale(icm42670_dev_t *sens, icm42670_gyro_fs_t gyro_fs, icm42670_acce_fs_t acce_fs);
+ static void icm42670_update_correction(icm42670_dev_t *sens);
+ static void icm42670_fifo_decode(const icm42670_dev_t *sens, const uint8_t *packet, icm42670_fifo_sample_t *sample);
+ #if !CONFIG_IDF_TARGET_LINUX
+ static void icm42670_int_isr(void *arg);
+ static esp_err_t icm42670_int_route(icm42670_handle_t sensor, icm42670_int_source_t source, bool enable);
+ #endif
+ 
+ static esp_err_t icm42670_get_raw_value(icm42670_handle_t sensor, uint8_t reg, icm42670_raw_value_t *value);
+ 
+ /*******************************************************************************
+ * Local variables
+ *******************************************************************************/
+ static const char *TAG = "ICM42670";
+ 
+ /*******************************************************************************
+ * Public API functions
+ *******************************************************************************/
+ 
+ esp_err_t icm42670_create(icm42670_bus_handle_t i2c_bus, const uint8_t dev_addr, icm42670_handle_t *handle_ret)
+ {
+     esp_err_t ret = ESP_OK;
+ 
+     // Allocate memory and init the driver object
+     icm42670_dev_t *sensor = (icm42670_dev_t *) calloc(1, sizeof(icm42670_dev_t));
+     struct timeval *timer = (struct timeval *) calloc(1, sizeof(struct timeval));
+     ESP_RETURN_ON_FALSE(sensor != NULL && timer != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+     sensor->timer = timer;
+ #if !CONFIG_IDF_TARGET_LINUX
+     sensor->int_gpio = GPIO_NUM_NC;
+     portMUX_INITIALIZE(&sensor->int_lock);
+ #endif
+     sensor->calib = (icm42670_calib_t) ICM42670_CALIB_DEFAULT();
+ 
+     // Add new I2C device
+     ESP_GOTO_ON_ERROR(icm42670_port_add_device(i2c_bus, dev_addr, &sensor->dev), err, TAG, "Failed to add new I2C device");
+     assert(sensor->dev);
+ 
+     // Check device presence
+     uint8_t dev_id = 0;
+     icm42670_get_deviceid(sensor, &dev_id);
+     ESP_GOTO_ON_FALSE(dev_id == ICM42607_ID || dev_id == ICM42670_ID, ESP_ERR_NOT_FOUND, err, TAG, "Incorrect Device ID (0x%02x).", dev_id);
+ 
+     ESP_LOGD(TAG, "Found device %s, ID: 0x%02x", (dev_id == ICM42607_ID ? "ICM42607" : "ICM42670"), dev_id);
+ 
+     // Pick up the current full-scale ranges once; icm42670_config() keeps them up to date
+     uint8_t fs_config[2];
+     ESP_GOTO_ON_ERROR(icm42670_read(sensor, ICM42670_GYRO_CONFIG0, fs_config, sizeof(fs_config)), err, TAG, "Failed to read config");
+     memcpy(&sensor->reg_shadow[ICM42670_GYRO_CONFIG0], fs_config, sizeof(fs_config));
+     sensor->reg_known |= (1ULL << ICM42670_GYRO_CONFIG0) | (1ULL << ICM42670_ACCEL_CONFIG0);
+     icm42670_set_full_scale(sensor, (fs_config[0] >> 5) & 0x03, (fs_config[1] >> 5) & 0x03);
+ 
+     *handle_ret = sensor;
+     return ret;
+ 
+ err:
+     icm42670_delete(sensor);
+     return ret;
+ }
+ 
+ void icm42670_delete(icm42670_handle_t sensor)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+     if (sens->int_gpio != GPIO_NUM_NC) {
+         icm42670_int_disable(sensor);
+     }
+ #endif
+ 
+     if (sens->dev) {
+         icm42670_port_rm_device(sens->dev);
+     }
+ 
+     if (sens->timer) {
+         free(sens->timer);
+     }
+ 
+     free(sens);
+ }
+ 
+ esp_err_t icm42670_get_deviceid(icm42670_handle_t sensor, uint8_t *deviceid)
+ {
+     esp_err_t ret = ESP_FAIL;
+ 
+     assert(deviceid != NULL);
+ 
+     for (int i = 0; (i < 5 && ret != ESP_OK); i++) {
+         ret = icm42670_read(sensor, ICM42670_WHOAMI, deviceid, 1);
+     }
+ 
+     return ret;
+ }
+ 
+ esp_err_t icm42670_config(icm42670_handle_t sensor, const icm42670_cfg_t *config)
+ {
+     uint8_t data[2];
+ 
+     assert(config != NULL);
+ 
+     /* Gyroscope */
+     data[0] = ((config->gyro_fs & 0x03) << 5) | (config->gyro_odr & 0x0F);
+     /* Accelerometer */
+     data[1] = ((config->acce_fs & 0x03) << 5) | (config->acce_odr & 0x0F);
+ 
+     esp_err_t ret = icm42670_write_shadowed(sensor, ICM42670_GYRO_CONFIG0, data, sizeof(data));
+     if (ret == ESP_OK) {
+         icm42670_set_full_scale(sensor, config->gyro_fs & 0x03, config->acce_fs & 0x03);
+     }
+ 
+     return ret;
+ }
+ 
+ esp_err_t icm42670_acce_set_pwr(icm42670_handle_t sensor, icm42670_acce_pwr_t state)
+ {
+     return icm42670_update_reg(sensor, ICM42670_PWR_MGMT0, ACCEL_MODE_MASK, state & 0x03);
+ }
+ 
+ esp_err_t icm42670_gyro_set_pwr(icm42670_handle_t sensor, icm42670_gyro_pwr_t state)
+ {
+     return icm42670_update_reg(sensor, ICM42670_PWR_MGMT0, GYRO_MODE_MASK, (state & 0x03) << 2);
+ }
+ 
+ esp_err_t icm42670_get_acce_sensitivity(icm42670_handle_t sensor, float *sensitivity)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     assert(sensitivity != NULL);
+ 
+     *sensitivity = sens->acce_sensitivity;
+ 
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_get_gyro_sensitivity(icm42670_handle_t sensor, float *sensitivity)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     assert(sensitivity != NULL);
+ 
+     *sensitivity = sens->gyro_sensitivity;
+ 
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_set_calibration(icm42670_handle_t sensor, const icm42670_calib_t *calib)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     assert(calib != NULL);
+     ESP_RETURN_ON_FALSE(calib->acce_scale.x > 0.0f && calib->acce_scale.y > 0.0f && calib->acce_scale.z > 0.0f,
+                         ESP_ERR_INVALID_ARG, TAG, "Invalid accelerometer scale");
+ 
+     sens->calib = *calib;
+     icm42670_update_correction(sens);
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_get_calibration(icm42670_handle_t sensor, icm42670_calib_t *calib)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     assert(calib != NULL);
+ 
+     *calib = sens->calib;
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_acce_raw_to_value(icm42670_handle_t sensor, const icm42670_raw_value_t *raw, icm42670_value_t *value)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     value->x = raw->x * sens->acce_gain.x - sens->acce_offset.x;
+     value->y = raw->y * sens->acce_gain.y - sens->acce_offset.y;
+     value->z = raw->z * sens->acce_gain.z - sens->acce_offset.z;
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_gyro_raw_to_value(icm42670_handle_t sensor, const icm42670_raw_value_t *raw, icm42670_value_t *value)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     value->x = raw->x * sens->gyro_gain - sens->calib.gyro_bias.x;
+     value->y = raw->y * sens->gyro_gain - sens->calib.gyro_bias.y;
+     value->z = raw->z * sens->gyro_gain - sens->calib.gyro_bias.z;
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_get_temp_raw_value(icm42670_handle_t sensor, uint16_t *value)
+ {
+     esp_err_t ret = ESP_FAIL;
+     uint8_t data[2];
+ 
+     assert(value != NULL);
+ 
+     *value = 0;
+ 
+     ret = icm42670_read(sensor, ICM42670_TEMP_DATA, data, sizeof(data));
+     if (ret == ESP_OK) {
+         *value = (uint16_t)((data[0] << 8) + data[1]);
+     }
+ 
+     return ret;
+ }
+ 
+ esp_err_t icm42670_get_acce_raw_value(icm42670_handle_t sensor, icm42670_raw_value_t *value)
+ {
+     return icm42670_get_raw_value(sensor, ICM42670_ACCEL_DATA, value);
+ }
+ 
+ esp_err_t icm42670_get_gyro_raw_value(icm42670_handle_t sensor, icm42670_raw_value_t *value)
+ {
+     return icm42670_get_raw_value(sensor, ICM42670_GYRO_DATA, value);
+ }
+ 
+ esp_err_t icm42670_get_all_raw_value(icm42670_handle_t sensor, icm42670_all_raw_value_t *value)
+ {
+     esp_err_t ret = ESP_FAIL;
+     uint8_t data[14];
+ 
+     assert(value != NULL);
+ 
+     memset(value, 0, sizeof(*value));
+ 
+     ret = icm42670_read(sensor, ICM42670_TEMP_DATA, data, sizeof(data));
+     if (ret == ESP_OK) {
+         value->temp = (int16_t)((data[0] << 8) + data[1]);
+         value->acce.x = (int16_t)((data[2] << 8) + data[3]);
+         value->acce.y = (int16_t)((data[4] << 8) + data[5]);
+         value->acce.z = (int16_t)((data[6] << 8) + data[7]);
+         value->gyro.x = (int16_t)((data[8] << 8) + data[9]);
+         value->gyro.y = (int16_t)((data[10] << 8) + data[11]);
+         value->gyro.z = (int16_t)((data[12] << 8) + data[13]);
+     }
+ 
+     return ret;
+ }
+ 
+ esp_err_t icm42670_get_all_value(icm42670_handle_t sensor, icm42670_all_value_t *value)
+ {
+     esp_err_t ret;
+     icm42670_all_raw_value_t raw_value;
+ 
+     assert(value != NULL);
+ 
+     memset(value, 0, sizeof(*value));
+ 
+     ret = icm42670_get_all_raw_value(sensor, &raw_value);
+     ESP_RETURN_ON_ERROR(ret, TAG, "Get raw value error!");
+ 
+     icm42670_acce_raw_to_value(sensor, &raw_value.acce, &value->acce);
+     icm42670_gyro_raw_to_value(sensor, &raw_value.gyro, &value->gyro);
+     value->temp = (raw_value.temp / 128.0f) + 25.0f;
+ 
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_get_acce_value(icm42670_handle_t sensor, icm42670_value_t *value)
+ {
+     esp_err_t ret;
+     icm42670_raw_value_t raw_value;
+ 
+     assert(value != NULL);
+ 
+     value->x = 0;
+     value->y = 0;
+     value->z = 0;
+ 
+     ret = icm42670_get_acce_raw_value(sensor, &raw_value);
+     ESP_RETURN_ON_ERROR(ret, TAG, "Get raw value error!");
+ 
+     return icm42670_acce_raw_to_value(sensor, &raw_value, value);
+ }
+ 
+ esp_err_t icm42670_get_gyro_value(icm42670_handle_t sensor, icm42670_value_t *value)
+ {
+     esp_err_t ret;
+     icm42670_raw_value_t raw_value;
+ 
+     assert(value != NULL);
+ 
+     value->x = 0;
+     value->y = 0;
+     value->z = 0;
+ 
+     ret = icm42670_get_gyro_raw_value(sensor, &raw_value);
+     ESP_RETURN_ON_ERROR(ret, TAG, "Get raw value error!");
+ 
+     return icm42670_gyro_raw_to_value(sensor, &raw_value, value);
+ }
+ 
+ esp_err_t icm42670_get_temp_value(icm42670_handle_t sensor, float *value)
+ {
+     esp_err_t ret;
+     uint16_t raw_value;
+ 
+     assert(value != NULL);
+ 
+     *value = 0;
+ 
+     ret = icm42670_get_temp_raw_value(sensor, &raw_value);
+     ESP_RETURN_ON_ERROR(ret, TAG, "Get raw value error!");
+ 
+     *value = ((float)raw_value / 128.0) + 25.0;
+ 
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_fifo_config(icm42670_handle_t sensor, const icm42670_fifo_cfg_t *config)
+ {
+     static const uint8_t packet_size[] = {
+         [ICM42670_FIFO_PACKET_ACCEL] = 8,
+         [ICM42670_FIFO_PACKET_GYRO] = 8,
+         [ICM42670_FIFO_PACKET_ACCEL_GYRO] = 16,
+     };
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t data[2];
+ 
+     assert(config != NULL);
+     ESP_RETURN_ON_FALSE(config->packet <= ICM42670_FIFO_PACKET_ACCEL_GYRO, ESP_ERR_INVALID_ARG, TAG, "Invalid packet format");
+     ESP_RETURN_ON_FALSE(config->watermark <= FIFO_WATERMARK_MAX &&
+                         config->watermark * packet_size[config->packet] <= ICM42670_FIFO_SIZE,
+                         ESP_ERR_INVALID_ARG, TAG, "Watermark larger than the FIFO");
+ 
+     ESP_RETURN_ON_ERROR(icm42670_fifo_disable(sensor), TAG, "FIFO bypass failed");
+ 
+     /* Count and watermark in records rather than bytes */
+     ESP_RETURN_ON_ERROR(icm42670_update_reg(sensor, ICM42670_INTF_CONFIG0, FIFO_COUNT_RECORDS_BIT, FIFO_COUNT_RECORDS_BIT),
+                         TAG, "INTF_CONFIG0 update failed");
+ 
+     uint8_t fifo_config5 = FIFO_WM_GT_TH_BIT;
+     if (config->packet != ICM42670_FIFO_PACKET_GYRO) {
+         fifo_config5 |= FIFO_ACCEL_EN_BIT;
+     }
+     if (config->packet != ICM42670_FIFO_PACKET_ACCEL) {
+         fifo_config5 |= FIFO_GYRO_EN_BIT;
+     }
+     ESP_RETURN_ON_ERROR(icm42670_write_mreg1(sensor, ICM42670_MREG1_FIFO_CONFIG5, fifo_config5), TAG, "FIFO_CONFIG5 write failed");
+ 
+     /* FIFO_CONFIG2/3: watermark, low byte first */
+     data[0] = config->watermark & 0xFF;
+     data[1] = (config->watermark >> 8) & 0x0F;
+     ESP_RETURN_ON_ERROR(icm42670_write_shadowed(sensor, ICM42670_FIFO_CONFIG2, data, 2), TAG, "Watermark write failed");
+ 
+     ESP_RETURN_ON_ERROR(icm42670_fifo_flush(sensor), TAG, "FIFO flush failed");
+     data[0] = config->stop_on_full ? FIFO_STOP_ON_FULL_BIT : 0;
+     ESP_RETURN_ON_ERROR(icm42670_write_shadowed(sensor, ICM42670_FIFO_CONFIG1, data, 1), TAG, "FIFO enable failed");
+ 
+     sens->fifo_packet = config->packet;
+     sens->fifo_packet_size = packet_size[config->packet];
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_fifo_disable(icm42670_handle_t sensor)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t data = FIFO_BYPASS_BIT;
+ 
+     sens->fifo_packet_size = 0;
+     return icm42670_write_shadowed(sensor, ICM42670_FIFO_CONFIG1, &data, 1);
+ }
+ 
+ esp_err_t icm42670_fifo_flush(icm42670_handle_t sensor)
+ {
+     uint8_t data = FIFO_FLUSH_BIT;
+ 
+     return icm42670_write(sensor, ICM42670_SIGNAL_PATH_RESET, &data, 1);
+ }
+ 
+ esp_err_t icm42670_fifo_get_count(icm42670_handle_t sensor, uint16_t *count)
+ {
+     esp_err_t ret;
+     uint8_t data[2];
+ 
+     assert(count != NULL);
+ 
+     *count = 0;
+ 
+     ret = icm42670_read(sensor, ICM42670_FIFO_COUNTH, data, sizeof(data));
+     if (ret == ESP_OK) {
+         *count = (uint16_t)((data[0] << 8) + data[1]);
+     }
+ 
+     return ret;
+ }
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+ esp_err_t icm42670_int_enable(icm42670_handle_t sensor, const icm42670_int_cfg_t *config)
+ {
+     esp_err_t ret = ESP_OK;
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t data;
+ 
+     assert(config != NULL);
+     ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(config->gpio), ESP_ERR_INVALID_ARG, TAG, "Invalid INT1 pin");
+     ESP_RETURN_ON_FALSE(config->source <= ICM42670_INT_APEX, ESP_ERR_INVALID_ARG, TAG, "Invalid interrupt source");
+ 
+     if (sens->int_gpio == config->gpio) {
+         /* Pin and ISR already set up: only switch what INT1 carries */
+         ESP_RETURN_ON_ERROR(icm42670_int_route(sensor, config->source, true), TAG, "Interrupt source update failed");
+         sens->int_source = config->source;
+         return ESP_OK;
+     }
+     if (sens->int_gpio != GPIO_NUM_NC) {
+         ESP_RETURN_ON_ERROR(icm42670_int_disable(sensor), TAG, "Interrupt disable failed");
+     }
+ 
+     /* Pulse mode: the pin drops again by itself, so no status read per sample */
+     data = INT1_PUSH_PULL_BIT | INT1_ACTIVE_HIGH_BIT;
+     ESP_RETURN_ON_ERROR(icm42670_write_shadowed(sensor, ICM42670_INT_CONFIG, &data, 1), TAG, "INT_CONFIG write failed");
+ 
+     const gpio_config_t io_cfg = {
+         .pin_bit_mask = 1ULL << config->gpio,
+         .mode = GPIO_MODE_INPUT,
+         .pull_up_en = GPIO_PULLUP_DISABLE,
+         .pull_down_en = GPIO_PULLDOWN_DISABLE,
+         .intr_type = GPIO_INTR_POSEDGE,
+     };
+     ESP_RETURN_ON_ERROR(gpio_config(&io_cfg), TAG, "INT1 pin config failed");
+ 
+     ret = gpio_install_isr_service(0);
+     ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "GPIO ISR service install failed");
+     ESP_RETURN_ON_ERROR(gpio_isr_handler_add(config->gpio, icm42670_int_isr, sens), TAG, "ISR handler add failed");
+     sens->int_gpio = config->gpio;
+ 
+     ESP_GOTO_ON_ERROR(icm42670_int_route(sensor, config->source, true), err, TAG, "Interrupt source write failed");
+     sens->int_source = config->source;
+ 
+     return ESP_OK;
+ 
+ err:
+     gpio_isr_handler_remove(config->gpio);
+     gpio_set_intr_type(config->gpio, GPIO_INTR_DISABLE);
+     sens->int_gpio = GPIO_NUM_NC;
+     return ret;
+ }
+ 
+ esp_err_t icm42670_int_disable(icm42670_handle_t sensor)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     esp_err_t ret = icm42670_int_route(sensor, sens->int_source, false);
+ 
+     if (sens->int_gpio != GPIO_NUM_NC) {
+         gpio_isr_handler_remove(sens->int_gpio);
+         gpio_set_intr_type(sens->int_gpio, GPIO_INTR_DISABLE);
+         sens->int_gpio = GPIO_NUM_NC;
+     }
+ 
+     return ret;
+ }
+ 
+ esp_err_t icm42670_int_wait(icm42670_handle_t sensor, TickType_t timeout, int64_t *timestamp_us)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     TaskHandle_t self = xTaskGetCurrentTaskHandle();
+ 
+     ESP_RETURN_ON_FALSE(sens->int_gpio != GPIO_NUM_NC, ESP_ERR_INVALID_STATE, TAG, "Interrupt not enabled");
+ 
+     if (sens->int_task != self) {
+         portENTER_CRITICAL(&sens->int_lock);
+         sens->int_task = self;
+         portEXIT_CRITICAL(&sens->int_lock);
+     }
+ 
+     uint32_t pulses = ulTaskNotifyTake(pdTRUE, timeout);
+     if (pulses == 0) {
+         return ESP_ERR_TIMEOUT;
+     }
+     if (pulses > 1) {
+         ESP_LOGD(TAG, "%" PRIu32 " interrupts since the last wait", pulses);
+     }
+ 
+     if (timestamp_us) {
+         portENTER_CRITICAL(&sens->int_lock);
+         *timestamp_us = sens->int_timestamp;
+         portEXIT_CRITICAL(&sens->int_lock);
+     }
+ 
+     return ESP_OK;
+ }
+ #endif
+ 
+ esp_err_t icm42670_apex_config(icm42670_handle_t sensor, const icm42670_apex_cfg_t *config)
+ {
+     /* DMP_ODR for each accelerometer ODR the DMP can run at */
+     static const struct {
+         uint8_t acce_odr;
+         uint8_t dmp_odr;
+     } dmp_odr[] = {
+         {ACCE_ODR_25HZ, 0}, {ACCE_ODR_400HZ, 1}, {ACCE_ODR_50HZ, 2}, {ACCE_ODR_100HZ, 3},
+     };
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t data;
+ 
+     assert(config != NULL);
+     ESP_RETURN_ON_FALSE((config->features & ~APEX_ALL_FEATURES) == 0, ESP_ERR_INVALID_ARG, TAG, "Invalid APEX feature");
+ 
+     /* Wake-on-motion compares each sample against a per-axis threshold */
+     if (config->features & ICM42670_APEX_WOM) {
+         for (uint8_t axis = 0; axis < 3; axis++) {
+             ESP_RETURN_ON_ERROR(icm42670_write_mreg1(sensor, ICM42670_MREG1_ACCEL_WOM_X_THR + axis, config->wom_threshold),
+                                 TAG, "WoM threshold write failed");
+         }
+         vTaskDelay(pdMS_TO_TICKS(WOM_THR_DELAY_MS) + 1);
+         data = WOM_EN_BIT | (config->wom_vs_previous ? WOM_MODE_PREVIOUS_BIT : 0);
+     } else {
+         data = 0;
+     }
+     ESP_RETURN_ON_ERROR(icm42670_write_shadowed(sensor, ICM42670_WOM_CONFIG, &data, 1), TAG, "WOM_CONFIG write failed");
+ 
+     /* Tilt and pedometer run on the DMP, which must tick at the accelerometer ODR */
+     if (config->features & (ICM42670_APEX_TILT | ICM42670_APEX_PEDOMETER)) {
+         const size_t odr_count = sizeof(dmp_odr) / sizeof(dmp_odr[0]);
+         size_t i = 0;
+ 
+         /* An empty mask changes nothing, but re-reads ACCEL_CONFIG0 if the shadow lost it */
+         ESP_RETURN_ON_ERROR(icm42670_update_reg(sensor, ICM42670_ACCEL_CONFIG0, 0, 0), TAG, "ACCEL_CONFIG0 read failed");
+         uint8_t acce_odr = sens->reg_shadow[ICM42670_ACCEL_CONFIG0] & 0x0F;
+         while (i < odr_count && dmp_odr[i].acce_odr != acce_odr) {
+             i++;
+         }
+         ESP_RETURN_ON_FALSE(i < odr_count, ESP_ERR_INVALID_STATE, TAG,
+                             "Tilt and pedometer need an accelerometer ODR of 25, 50, 100 or 400 Hz");
+ 
+         /* Keep DMP_POWER_SAVE_EN and the rest of APEX_CONFIG0; the reset and init bits clear themselves */
+         uint8_t apex_config0;
+         ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_APEX_CONFIG0, &apex_config0, 1), TAG, "APEX_CONFIG0 read failed");
+         apex_config0 &= ~(DMP_MEM_RESET_BIT | DMP_INIT_EN_BIT);
+ 
+         data = apex_config0 | DMP_MEM_RESET_BIT;
+         ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_APEX_CONFIG0, &data, 1), TAG, "DMP reset failed");
+         vTaskDelay(pdMS_TO_TICKS(DMP_RESET_DELAY_MS) + 1);
+ 
+         data = dmp_odr[i].dmp_odr;
+         if (config->features & ICM42670_APEX_TILT) {
+             data |= TILT_ENABLE_BIT;
+         }
+         if (config->features & ICM42670_APEX_PEDOMETER) {
+             data |= PED_ENABLE_BIT;
+         }
+         ESP_RETURN_ON_ERROR(icm42670_update_reg(sensor, ICM42670_APEX_CONFIG1, TILT_ENABLE_BIT | PED_ENABLE_BIT | DMP_ODR_MASK, data),
+                             TAG, "APEX_CONFIG1 write failed");
+ 
+         data = apex_config0 | DMP_INIT_EN_BIT;
+         ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_APEX_CONFIG0, &data, 1), TAG, "DMP init failed");
+         vTaskDelay(pdMS_TO_TICKS(DMP_INIT_DELAY_MS));
+     } else {
+         ESP_RETURN_ON_ERROR(icm42670_update_reg(sensor, ICM42670_APEX_CONFIG1, TILT_ENABLE_BIT | PED_ENABLE_BIT, 0),
+                             TAG, "APEX_CONFIG1 write failed");
+     }
+ 
+     sens->apex_features = config->features;
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+     /* Pick up the new set if INT1 is already carrying APEX events */
+     if (sens->int_gpio != GPIO_NUM_NC && sens->int_source == ICM42670_INT_APEX) {
+         ESP_RETURN_ON_ERROR(icm42670_int_route(sensor, ICM42670_INT_APEX, true), TAG, "Interrupt source update failed");
+     }
+ #endif
+ 
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_apex_get_events(icm42670_handle_t sensor, uint32_t *events)
+ {
+     uint8_t status[2];  /* INT_STATUS2, INT_STATUS3; both clear on read */
+ 
+     assert(events != NULL);
+ 
+     *events = 0;
+ 
+     ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_INT_STATUS2, status, sizeof(status)), TAG, "Status read failed");
+     if (status[0] & WOM_XYZ_INT_BITS) {
+         *events |= ICM42670_APEX_WOM;
+     }
+     if (status[1] & TILT_DET_INT_BIT) {
+         *events |= ICM42670_APEX_TILT;
+     }
+     if (status[1] & STEP_DET_INT_BIT) {
+         *events |= ICM42670_APEX_PEDOMETER;
+     }
+ 
+     return ESP_OK;
+ }
+ 
+ esp_err_t icm42670_apex_get_step_count(icm42670_handle_t sensor, uint16_t *steps)
+ {
+     esp_err_t ret;
+     uint8_t data[2];
+ 
+     assert(steps != NULL);
+ 
+     *steps = 0;
+ 
+     ret = icm42670_read(sensor, ICM42670_APEX_DATA0, data, sizeof(data));
+     if (ret == ESP_OK) {
+         *steps = (uint16_t)((data[1] << 8) + data[0]);
+     }
+ 
+     return ret;
+ }
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+ esp_err_t icm42670_apex_wait_motion(icm42670_handle_t sensor, TickType_t timeout)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     icm42670_int_source_t resume = sens->int_source;
+     uint32_t events = 0;
+ 
+     ESP_RETURN_ON_FALSE(sens->int_gpio != GPIO_NUM_NC, ESP_ERR_INVALID_STATE, TAG, "Interrupt not enabled");
+     ESP_RETURN_ON_FALSE(sens->apex_features & ICM42670_APEX_WOM, ESP_ERR_INVALID_STATE, TAG, "Wake-on-motion not enabled");
+ 
+     ESP_RETURN_ON_ERROR(icm42670_int_route(sensor, ICM42670_INT_APEX, true), TAG, "Interrupt source update failed");
+     sens->int_source = ICM42670_INT_APEX;
+ 
+     /* Whatever latched while INT1 carried something else is stale */
+     esp_err_t ret = icm42670_apex_get_events(sensor, &events);
+     TickType_t start = xTaskGetTickCount();
+     while (ret == ESP_OK) {
+         TickType_t waited = xTaskGetTickCount() - start;
+         TickType_t left = (timeout == portMAX_DELAY) ? portMAX_DELAY : (waited < timeout ? timeout - waited : 0);
+ 
+         ret = icm42670_int_wait(sensor, left, NULL);
+         if (ret == ESP_OK) {
+             ret = icm42670_apex_get_events(sensor, &events);
+         }
+         if (ret == ESP_OK && (events & ICM42670_APEX_WOM)) {
+             break;
+         }
+     }
+ 
+     esp_err_t route_ret = icm42670_int_route(sensor, resume, true);
+     if (route_ret == ESP_OK) {
+         sens->int_source = resume;
+     } else if (ret == ESP_OK) {
+         ret = route_ret;
+     }
+     return ret;
+ }
+ #endif
+ 
+ esp_err_t icm42670_fifo_read(icm42670_handle_t sensor, icm42670_fifo_sample_t *samples, size_t max_samples, size_t *count)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint16_t available;
+ 
+     /* Raw packets are read straight into the caller's array and decoded in place */
+     _Static_assert(sizeof(icm42670_fifo_sample_t) >= 16, "FIFO sample smaller than the largest packet");
+ 
+     assert(samples != NULL && count != NULL);
+ 
+     *count = 0;
+     ESP_RETURN_ON_FALSE(sens->fifo_packet_size != 0, ESP_ERR_INVALID_STATE, TAG, "FIFO not configured");
+ 
+     ESP_RETURN_ON_ERROR(icm42670_fifo_get_count(sensor, &available), TAG, "FIFO count read failed");
+     size_t n = (available < max_samples) ? available : max_samples;
+     if (n == 0) {
+         return ESP_OK;
+     }
+ 
+     uint8_t *raw = (uint8_t *) samples;
+     const size_t psize = sens->fifo_packet_size;
+     ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_FIFO_DATA, raw, n * psize), TAG, "FIFO data read failed");
+ 
+     /*
+      * Sample i is at least as large as a packet, so it only overlaps packet i and
+      * later ones. Decoding from the back, each packet is copied out before its
+      * bytes can be overwritten.
+      */
+     size_t valid = n;
+     for (size_t i = n; i-- > 0;) {
+         uint8_t packet[16];
+         memcpy(packet, &raw[i * psize], psize);
+         if (packet[0] & FIFO_HEADER_EMPTY_BIT) {
+             valid = i;  /* Ran past the end of the FIFO */
+             continue;
+         }
+         icm42670_fifo_decode(sens, packet, &samples[i]);
+     }
+ 
+     *count = valid;
+     return ESP_OK;
+ }
+ 
+ /*******************************************************************************
+ * Private functions
+ *******************************************************************************/
+ 
+ static void icm42670_set_full_scale(icm42670_dev_t *sens, icm42670_gyro_fs_t gyro_fs, icm42670_acce_fs_t acce_fs)
+ {
+     static const float gyro_sensitivity[] = {
+         [GYRO_FS_2000DPS] = GYRO_FS_2000_SENSITIVITY,
+         [GYRO_FS_1000DPS] = GYRO_FS_1000_SENSITIVITY,
+         [GYRO_FS_500DPS]  = GYRO_FS_500_SENSITIVITY,
+         [GYRO_FS_250DPS]  = GYRO_FS_250_SENSITIVITY,
+     };
+     static const float acce_sensitivity[] = {
+         [ACCE_FS_16G] = ACCE_FS_16G_SENSITIVITY,
+         [ACCE_FS_8G]  = ACCE_FS_8G_SENSITIVITY,
+         [ACCE_FS_4G]  = ACCE_FS_4G_SENSITIVITY,
+         [ACCE_FS_2G]  = ACCE_FS_2G_SENSITIVITY,
+     };
+ 
+     sens->gyro_sensitivity = gyro_sensitivity[gyro_fs];
+     sens->acce_sensitivity = acce_sensitivity[acce_fs];
+     icm42670_update_correction(sens);
+ }
+ 
+ /* Fold sensitivity and calibration into one multiply-subtract per axis */
+ static void icm42670_update_correction(icm42670_dev_t *sens)
+ {
+     const icm42670_calib_t *calib = &sens->calib;
+     float acce_scale = 1.0f / sens->acce_sensitivity;
+ 
+     sens->acce_gain.x = calib->acce_scale.x * acce_scale;
+     sens->acce_gain.y = calib->acce_scale.y * acce_scale;
+     sens->acce_gain.z = calib->acce_scale.z * acce_scale;
+     sens->acce_offset.x = calib->acce_bias.x * calib->acce_scale.x;
+     sens->acce_offset.y = calib->acce_bias.y * calib->acce_scale.y;
+     sens->acce_offset.z = calib->acce_bias.z * calib->acce_scale.z;
+     sens->gyro_gain = 1.0f / sens->gyro_sensitivity;
+ }
+ 
+ static void icm42670_fifo_decode(const icm42670_dev_t *sens, const uint8_t *packet, icm42670_fifo_sample_t *sample)
+ {
+     const uint8_t *acce = NULL;
+     const uint8_t *gyro = NULL;
+     int8_t temp;
+ 
+     switch (sens->fifo_packet) {
+     case ICM42670_FIFO_PACKET_ACCEL:
+         acce = &packet[1];
+         temp = (int8_t) packet[7];
+         sample->timestamp = 0;
+         break;
+     case ICM42670_FIFO_PACKET_GYRO:
+         gyro = &packet[1];
+         temp = (int8_t) packet[7];
+         sample->timestamp = 0;
+         break;
+     default:
+         acce = &packet[1];
+         gyro = &packet[7];
+         temp = (int8_t) packet[13];
+         sample->timestamp = (uint16_t)((packet[14] << 8) + packet[15]);
+         break;
+     }
+ 
+     sample->header = packet[0];
+     sample->acce.x = acce ? (int16_t)((acce[0] << 8) + acce[1]) : ICM42670_FIFO_INVALID;
+     sample->acce.y = acce ? (int16_t)((acce[2] << 8) + acce[3]) : ICM42670_FIFO_INVALID;
+     sample->acce.z = acce ? (int16_t)((acce[4] << 8) + acce[5]) : ICM42670_FIFO_INVALID;
+     sample->gyro.x = gyro ? (int16_t)((gyro[0] << 8) + gyro[1]) : ICM42670_FIFO_INVALID;
+     sample->gyro.y = gyro ? (int16_t)((gyro[2] << 8) + gyro[3]) : ICM42670_FIFO_INVALID;
+     sample->gyro.z = gyro ? (int16_t)((gyro[4] << 8) + gyro[5]) : ICM42670_FIFO_INVALID;
+     /* 8-bit FIFO temperature is 2 LSB/C, the register is 128 LSB/C */
+     sample->temp = (int16_t)(temp * 64);
+ }
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+ /* INT1 edge: stamp the time and wake the task waiting in icm42670_int_wait() */
+ static void IRAM_ATTR icm42670_int_isr(void *arg)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) arg;
+     BaseType_t woken = pdFALSE;
+     int64_t now = esp_timer_get_time();
+     TaskHandle_t task;
+ 
+     portENTER_CRITICAL_ISR(&sens->int_lock);
+     sens->int_timestamp = now;
+     task = sens->int_task;
+     portEXIT_CRITICAL_ISR(&sens->int_lock);
+ 
+     if (task) {
+         vTaskNotifyGiveFromISR(task, &woken);
+     }
+     if (woken) {
+         portYIELD_FROM_ISR();
+     }
+ }
+ 
+ /* Point INT1 at one kind of event, or at nothing; the APEX engines keep running either way */
+ static esp_err_t icm42670_int_route(icm42670_handle_t sensor, icm42670_int_source_t source, bool enable)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t int_source[2] = {0, 0};     /* INT_SOURCE0, INT_SOURCE1 */
+     uint8_t int_source6 = 0;
+ 
+     if (enable && source == ICM42670_INT_DATA_READY) {
+         int_source[0] = DRDY_INT1_EN_BIT;
+     } else if (enable && source == ICM42670_INT_FIFO_THS) {
+         int_source[0] = FIFO_THS_INT1_EN_BIT;
+     } else if (enable && source == ICM42670_INT_APEX) {
+         if (sens->apex_features & ICM42670_APEX_WOM) {
+             int_source[1] = WOM_XYZ_INT1_EN_BITS;
+         }
+         if (sens->apex_features & ICM42670_APEX_TILT) {
+             int_source6 |= TILT_DET_INT1_EN_BIT;
+         }
+         if (sens->apex_features & ICM42670_APEX_PEDOMETER) {
+             int_source6 |= STEP_DET_INT1_EN_BIT;
+         }
+     }
+ 
+     ESP_RETURN_ON_ERROR(icm42670_write_shadowed(sensor, ICM42670_INT_SOURCE0, int_source, sizeof(int_source)), TAG, "INT_SOURCE write failed");
+     if (int_source6 != sens->int_source6) {
+         ESP_RETURN_ON_ERROR(icm42670_write_mreg1(sensor, ICM42670_MREG1_INT_SOURCE6, int_source6), TAG, "INT_SOURCE6 write failed");
+         sens->int_source6 = int_source6;
+     }
+ 
+     return ESP_OK;
+ }
+ #endif
+ 
+ /* Single write to a MREG1 register: select the bank, address and value in one burst */
+ static esp_err_t icm42670_write_mreg1(icm42670_handle_t sensor, const uint8_t reg, const uint8_t value)
+ {
+     esp_err_t ret = ESP_OK;
+     uint8_t data[3] = {0x00, reg, value};  /* BLK_SEL_W = MREG1, MADDR_W, M_W */
+     uint8_t mclk = 0;
+     bool idle_set = false;
+ 
+     /* The write is dropped without MCLK; with both sensors off, hold IDLE to run it */
+     ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_MCLK_RDY, &mclk, 1), TAG, "MCLK_RDY read failed");
+     if (!(mclk & MCLK_RDY_BIT)) {
+         ESP_RETURN_ON_ERROR(icm42670_update_reg(sensor, ICM42670_PWR_MGMT0, PWR_IDLE_BIT, PWR_IDLE_BIT), TAG, "IDLE set failed");
+         idle_set = true;
+         for (int i = 0; i < ICM42670_MCLK_RDY_POLLS && !(mclk & MCLK_RDY_BIT); i++) {
+             ESP_GOTO_ON_ERROR(icm42670_read(sensor, ICM42670_MCLK_RDY, &mclk, 1), err, TAG, "MCLK_RDY read failed");
+         }
+         ESP_GOTO_ON_FALSE(mclk & MCLK_RDY_BIT, ESP_ERR_INVALID_STATE, err, TAG, "MCLK not running");
+     }
+ 
+     ret = icm42670_write(sensor, ICM42670_BLK_SEL_W, data, sizeof(data));
+     icm42670_port_delay_us(ICM42670_MREG_WRITE_DELAY_US);
+ 
+ err:
+     if (idle_set) {
+         esp_err_t idle_ret = icm42670_update_reg(sensor, ICM42670_PWR_MGMT0, PWR_IDLE_BIT, 0);
+         if (ret == ESP_OK) {
+             ret = idle_ret;
+         }
+     }
+     return ret;
+ }
+ 
+ /* Write only the span of registers that differs from the shadow; nothing if none does */
+ static esp_err_t icm42670_write_shadowed(icm42670_handle_t sensor, const uint8_t reg_start_addr, const uint8_t *data_buf, const uint8_t data_len)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t first = 0;
+     uint8_t last = data_len;
+ 
+     assert(reg_start_addr + data_len <= ICM42670_SHADOW_SIZE);
+ 
+     while (first < last && (sens->reg_known & (1ULL << (reg_start_addr + first))) &&
+             sens->reg_shadow[reg_start_addr + first] == data_buf[first]) {
+         first++;
+     }
+     while (last > first && (sens->reg_known & (1ULL << (reg_start_addr + last - 1))) &&
+             sens->reg_shadow[reg_start_addr + last - 1] == data_buf[last - 1]) {
+         last--;
+     }
+     if (first == last) {
+         return ESP_OK;
+     }
+ 
+     uint64_t span = ((1ULL << (last - first)) - 1) << (reg_start_addr + first);
+     esp_err_t ret = icm42670_write(sensor, reg_start_addr + first, &data_buf[first], last - first);
+     if (ret == ESP_OK) {
+         memcpy(&sens->reg_shadow[reg_start_addr + first], &data_buf[first], last - first);
+         sens->reg_known |= span;
+     } else {
+         sens->reg_known &= ~span;   /* The device may hold either value now */
+     }
+ 
+     return ret;
+ }
+ 
+ /* Replace the bits in mask; the register is read once, the first time it is touched */
+ static esp_err_t icm42670_update_reg(icm42670_handle_t sensor, const uint8_t reg, const uint8_t mask, const uint8_t value)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     uint8_t data;
+ 
+     assert(reg < ICM42670_SHADOW_SIZE);
+ 
+     if (!(sens->reg_known & (1ULL << reg))) {
+         ESP_RETURN_ON_ERROR(icm42670_read(sensor, reg, &sens->reg_shadow[reg], 1), TAG, "Register read failed");
+         sens->reg_known |= 1ULL << reg;
+     }
+ 
+     data = (sens->reg_shadow[reg] & ~mask) | (value & mask);
+     return icm42670_write_shadowed(sensor, reg, &data, 1);
+ }
+ 
+ static esp_err_t icm42670_get_raw_value(icm42670_handle_t sensor, uint8_t reg, icm42670_raw_value_t *value)
+ {
+     esp_err_t ret = ESP_FAIL;
+     uint8_t data[6];
+ 
+     assert(value != NULL);
+ 
+     value->x = 0;
+     value->y = 0;
+     value->z = 0;
+ 
+     ret = icm42670_read(sensor, reg, data, sizeof(data));
+     if (ret == ESP_OK) {
+         value->x = (int16_t)((data[0] << 8) + data[1]);
+         value->y = (int16_t)((data[2] << 8) + data[3]);
+         value->z = (int16_t)((data[4] << 8) + data[5]);
+     }
+ 
+     return ret;
+ }
+ 
+ static esp_err_t icm42670_write(icm42670_handle_t sensor, const uint8_t reg_start_addr, const uint8_t *data_buf, const uint8_t data_len)
+ {
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     assert(sens);
+ 
+     assert(data_len < 5);
+     uint8_t write_buff[5] = {reg_start_addr};
+     memcpy(&write_buff[1], data_buf, data_len);
+     return icm42670_port_write(sens->dev, write_buff, data_len + 1);
+ }
+ 
+ static esp_err_t icm42670_read(icm42670_handle_t sensor, const uint8_t reg_start_addr, uint8_t *data_buf, const size_t data_len)
+ {
+     uint8_t reg_buff[] = {reg_start_addr};
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+     assert(sens);
+ 
+     /* Write register number and read data */
+     return icm42670_port_write_read(sens->dev, reg_buff, sizeof(reg_buff), data_buf, data_len);
+ }
+ 
+ esp_err_t icm42670_complimentory_filter(icm42670_handle_t sensor, const icm42670_value_t *const acce_value,
+                                         const icm42670_value_t *const gyro_value, complimentary_angle_t *const complimentary_angle)
+ {
+     float acce_angle[2];
+     float gyro_angle[2];
+     float gyro_rate[2];
+     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+ 
+     sens->counter++;
+     if (sens->counter == 1) {
+         acce_angle[0] = (atan2(acce_value->y, acce_value->z) * RAD_TO_DEG);
+         acce_angle[1] = (atan2(acce_value->x, acce_value->z) * RAD_TO_DEG);
+         complimentary_angle->roll = acce_angle[0];
+         complimentary_angle->pitch = acce_angle[1];
+         gettimeofday(sens->timer, NULL);
+         return ESP_OK;
+     }
+ 
+     struct timeval now, dt_t;
+     gettimeofday(&now, NULL);
+     timersub(&now, sens->timer, &dt_t);
+     sens->dt = (float) (dt_t.tv_sec) + (float)dt_t.tv_usec / 1000000;
+     gettimeofday(sens->timer, NULL);
+ 
+     acce_angle[0] = (atan2(acce_value->y, acce_value->z) * RAD_TO_DEG);
+     acce_angle[1] = (atan2(acce_value->x, acce_value->z) * RAD_TO_DEG);
+ 
+     gyro_rate[0] = gyro_value->x;
+     gyro_rate[1] = gyro_value->y;
+     gyro_angle[0] = gyro_rate[0] * sens->dt;
+     gyro_angle[1] = gyro_rate[1] * sens->dt;
+ 
+     complimentary_angle->roll = (ALPHA * (complimentary_angle->roll + gyro_angle[0])) + ((1 - ALPHA) * acce_angle[0]);
+     complimentary_angle->pitch = (ALPHA * (complimentary_angle->pitch + gyro_angle[1])) + ((1 - ALPHA) * acce_angle[1]);
+ 
+     return ESP_OK;
+ }
\ No newline at end of file
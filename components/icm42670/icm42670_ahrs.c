@@ -0,0 +1,294 @@
+#include <math.h>
+#include <stdlib.h>
+#include "esp_check.h"
+#include "icm42670_ahrs.h"
+#include "icm42670_fusion.h"
+
+#define DEG_TO_RAD      0.01745329252f
+#define RAD_TO_DEG      57.29577951f
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef struct {
+    icm42670_ahrs_config_t config;
+    float dt;                   /*!< 1 / sample_rate_hz */
+    bool started;
+    icm42670_quaternion_t q;
+    icm42670_value_t bias;      /*!< Mahony integral term, rad/s */
+    icm42670_value_t acce;      /*!< Last accelerometer reading, g */
+} icm42670_ahrs_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static void icm42670_ahrs_init_from_acce(icm42670_ahrs_t *ahrs, const icm42670_value_t *acce);
+static void icm42670_ahrs_madgwick(icm42670_ahrs_t *ahrs, float ax, float ay, float az,
+                                   float gx, float gy, float gz, bool correct);
+static void icm42670_ahrs_mahony(icm42670_ahrs_t *ahrs, float ax, float ay, float az,
+                                 float gx, float gy, float gz, bool correct);
+static void icm42670_ahrs_normalize(icm42670_quaternion_t *q);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "ICM42670_AHRS";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t icm42670_ahrs_create(const icm42670_ahrs_config_t *config, icm42670_ahrs_handle_t *handle_ret)
+{
+    assert(config != NULL && handle_ret != NULL);
+
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) calloc(1, sizeof(icm42670_ahrs_t));
+    ESP_RETURN_ON_FALSE(ahrs != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+
+    esp_err_t ret = icm42670_ahrs_set_config(ahrs, config);
+    if (ret != ESP_OK) {
+        free(ahrs);
+        return ret;
+    }
+    icm42670_ahrs_reset(ahrs);
+
+    *handle_ret = ahrs;
+    return ESP_OK;
+}
+
+void icm42670_ahrs_delete(icm42670_ahrs_handle_t handle)
+{
+    free(handle);
+}
+
+esp_err_t icm42670_ahrs_set_config(icm42670_ahrs_handle_t handle, const icm42670_ahrs_config_t *config)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+
+    assert(config != NULL);
+    ESP_RETURN_ON_FALSE(config->algorithm <= ICM42670_AHRS_MAHONY, ESP_ERR_INVALID_ARG, TAG, "Invalid algorithm");
+    ESP_RETURN_ON_FALSE(config->sample_rate_hz > 0.0f, ESP_ERR_INVALID_ARG, TAG, "Invalid sample rate");
+
+    ahrs->config = *config;
+    ahrs->dt = 1.0f / config->sample_rate_hz;
+    return ESP_OK;
+}
+
+void icm42670_ahrs_reset(icm42670_ahrs_handle_t handle)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+
+    ahrs->started = false;
+    ahrs->q = (icm42670_quaternion_t) {1.0f, 0.0f, 0.0f, 0.0f};
+    ahrs->bias = (icm42670_value_t) {0.0f, 0.0f, 0.0f};
+    ahrs->acce = (icm42670_value_t) {0.0f, 0.0f, 1.0f};
+}
+
+void icm42670_ahrs_update(icm42670_ahrs_handle_t handle, const icm42670_value_t *acce, const icm42670_value_t *gyro)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+    float norm2 = acce->x * acce->x + acce->y * acce->y + acce->z * acce->z;
+
+    ahrs->acce = *acce;
+
+    if (!ahrs->started) {
+        if (norm2 > 0.0f) {
+            icm42670_ahrs_init_from_acce(ahrs, acce);
+            ahrs->started = true;
+        }
+        return;
+    }
+
+    // A free-falling or shaken board says little about where down is
+    bool correct = norm2 > 0.0f;
+    if (correct && ahrs->config.acce_reject_g > 0.0f) {
+        float lo = 1.0f - ahrs->config.acce_reject_g;
+        float hi = 1.0f + ahrs->config.acce_reject_g;
+        correct = norm2 >= lo * lo && norm2 <= hi * hi;
+    }
+
+    float inv_norm = correct ? 1.0f / sqrtf(norm2) : 0.0f;
+    float ax = acce->x * inv_norm;
+    float ay = acce->y * inv_norm;
+    float az = acce->z * inv_norm;
+    float gx = gyro->x * DEG_TO_RAD;
+    float gy = gyro->y * DEG_TO_RAD;
+    float gz = gyro->z * DEG_TO_RAD;
+
+    if (ahrs->config.algorithm == ICM42670_AHRS_MADGWICK) {
+        icm42670_ahrs_madgwick(ahrs, ax, ay, az, gx, gy, gz, correct);
+    } else {
+        icm42670_ahrs_mahony(ahrs, ax, ay, az, gx, gy, gz, correct);
+    }
+}
+
+void icm42670_ahrs_update_batch(icm42670_ahrs_handle_t handle, const icm42670_all_value_t *samples, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        icm42670_ahrs_update(handle, &samples[i].acce, &samples[i].gyro);
+    }
+}
+
+void icm42670_ahrs_get_quaternion(icm42670_ahrs_handle_t handle, icm42670_quaternion_t *q)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+
+    assert(q != NULL);
+    *q = ahrs->q;
+}
+
+void icm42670_ahrs_get_euler(icm42670_ahrs_handle_t handle, icm42670_euler_t *euler)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+    const icm42670_quaternion_t *q = &ahrs->q;
+
+    assert(euler != NULL);
+
+    float sin_pitch = 2.0f * (q->w * q->y - q->z * q->x);
+    if (sin_pitch > 1.0f) {
+        sin_pitch = 1.0f;
+    } else if (sin_pitch < -1.0f) {
+        sin_pitch = -1.0f;
+    }
+
+    euler->roll = icm42670_fast_atan2_deg(2.0f * (q->w * q->x + q->y * q->z),
+                                          1.0f - 2.0f * (q->x * q->x + q->y * q->y));
+    euler->pitch = asinf(sin_pitch) * RAD_TO_DEG;
+    euler->yaw = icm42670_fast_atan2_deg(2.0f * (q->w * q->z + q->x * q->y),
+                                         1.0f - 2.0f * (q->y * q->y + q->z * q->z));
+}
+
+void icm42670_ahrs_get_gravity(icm42670_ahrs_handle_t handle, icm42670_value_t *gravity)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+    const icm42670_quaternion_t *q = &ahrs->q;
+
+    assert(gravity != NULL);
+
+    // World Z rotated into the sensor frame: third row of the rotation matrix
+    gravity->x = 2.0f * (q->x * q->z - q->w * q->y);
+    gravity->y = 2.0f * (q->w * q->x + q->y * q->z);
+    gravity->z = q->w * q->w - q->x * q->x - q->y * q->y + q->z * q->z;
+}
+
+void icm42670_ahrs_get_linear_acce(icm42670_ahrs_handle_t handle, icm42670_value_t *linear)
+{
+    icm42670_ahrs_t *ahrs = (icm42670_ahrs_t *) handle;
+    icm42670_value_t gravity;
+
+    assert(linear != NULL);
+
+    icm42670_ahrs_get_gravity(handle, &gravity);
+    linear->x = ahrs->acce.x - gravity.x;
+    linear->y = ahrs->acce.y - gravity.y;
+    linear->z = ahrs->acce.z - gravity.z;
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static void icm42670_ahrs_init_from_acce(icm42670_ahrs_t *ahrs, const icm42670_value_t *acce)
+{
+    float roll = atan2f(acce->y, acce->z) * 0.5f;
+    float pitch = atan2f(-acce->x, sqrtf(acce->y * acce->y + acce->z * acce->z)) * 0.5f;
+    float cr = cosf(roll), sr = sinf(roll);
+    float cp = cosf(pitch), sp = sinf(pitch);
+
+    ahrs->q.w = cr * cp;
+    ahrs->q.x = sr * cp;
+    ahrs->q.y = cr * sp;
+    ahrs->q.z = -sr * sp;
+}
+
+static void icm42670_ahrs_madgwick(icm42670_ahrs_t *ahrs, float ax, float ay, float az,
+                                   float gx, float gy, float gz, bool correct)
+{
+    icm42670_quaternion_t *q = &ahrs->q;
+    const float q0 = q->w, q1 = q->x, q2 = q->y, q3 = q->z;
+
+    // Rate of change from the gyroscope
+    float dq0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float dq1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float dq2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float dq3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (correct) {
+        // Gradient of the error between measured and predicted gravity
+        const float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+        const float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+        const float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+        const float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        float norm2 = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (norm2 > 0.0f) {
+            float k = ahrs->config.beta / sqrtf(norm2);
+            dq0 -= k * s0;
+            dq1 -= k * s1;
+            dq2 -= k * s2;
+            dq3 -= k * s3;
+        }
+    }
+
+    q->w = q0 + dq0 * ahrs->dt;
+    q->x = q1 + dq1 * ahrs->dt;
+    q->y = q2 + dq2 * ahrs->dt;
+    q->z = q3 + dq3 * ahrs->dt;
+    icm42670_ahrs_normalize(q);
+}
+
+static void icm42670_ahrs_mahony(icm42670_ahrs_t *ahrs, float ax, float ay, float az,
+                                 float gx, float gy, float gz, bool correct)
+{
+    icm42670_quaternion_t *q = &ahrs->q;
+    const float q0 = q->w, q1 = q->x, q2 = q->y, q3 = q->z;
+
+    if (correct) {
+        // Predicted gravity, then the rotation that would take it onto the measured one
+        float vx = 2.0f * (q1 * q3 - q0 * q2);
+        float vy = 2.0f * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        if (ahrs->config.ki > 0.0f) {
+            ahrs->bias.x += ahrs->config.ki * ex * ahrs->dt;
+            ahrs->bias.y += ahrs->config.ki * ey * ahrs->dt;
+            ahrs->bias.z += ahrs->config.ki * ez * ahrs->dt;
+        } else {
+            ahrs->bias = (icm42670_value_t) {0.0f, 0.0f, 0.0f};
+        }
+
+        gx += ahrs->config.kp * ex + ahrs->bias.x;
+        gy += ahrs->config.kp * ey + ahrs->bias.y;
+        gz += ahrs->config.kp * ez + ahrs->bias.z;
+    } else {
+        gx += ahrs->bias.x;
+        gy += ahrs->bias.y;
+        gz += ahrs->bias.z;
+    }
+
+    const float h = 0.5f * ahrs->dt;
+    q->w = q0 + (-q1 * gx - q2 * gy - q3 * gz) * h;
+    q->x = q1 + (q0 * gx + q2 * gz - q3 * gy) * h;
+    q->y = q2 + (q0 * gy - q1 * gz + q3 * gx) * h;
+    q->z = q3 + (q0 * gz + q1 * gy - q2 * gx) * h;
+    icm42670_ahrs_normalize(q);
+}
+
+static void icm42670_ahrs_normalize(icm42670_quaternion_t *q)
+{
+    float inv_norm = 1.0f / sqrtf(q->w * q->w + q->x * q->x + q->y * q->y + q->z * q->z);
+
+    q->w *= inv_norm;
+    q->x *= inv_norm;
+    q->y *= inv_norm;
+    q->z *= inv_norm;
+}
@@ -0,0 +1,246 @@
+#include <inttypes.h>
+#include <math.h>
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "icm42670_calib.h"
+
+#define CALIB_BLOB_VERSION      1
+#define CALIB_AXIS_TOLERANCE_G  0.25f   /* How far off +/-1 g a six-position capture may be */
+#define CALIB_SCALE_MIN         0.8f    /* Stored scale outside these is taken as corrupt */
+#define CALIB_SCALE_MAX         1.25f
+#define CALIB_SIX_POS_ALL       0x3F
+
+/* The data registers read -32768 while the sensor is off */
+#define SENSOR_OFF              INT16_MIN
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef struct {
+    uint32_t version;
+    icm42670_calib_t calib;
+} icm42670_calib_blob_t;
+
+typedef struct {
+    float acce[3];
+    float gyro[3];
+    bool gyro_on;
+} icm42670_calib_mean_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static esp_err_t icm42670_calib_average(icm42670_handle_t sensor, uint16_t samples, uint32_t period_ms,
+                                        icm42670_calib_mean_t *mean);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "ICM42670_CALIB";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t icm42670_calib_estimate_bias(icm42670_handle_t sensor, uint16_t samples, uint32_t period_ms,
+                                       icm42670_calib_t *calib)
+{
+    icm42670_calib_mean_t mean;
+
+    assert(calib != NULL);
+    ESP_RETURN_ON_ERROR(icm42670_calib_average(sensor, samples, period_ms, &mean), TAG, "Average error!");
+
+    // Flat and still, so the true reading is (0, 0, 1 g) after scaling
+    calib->acce_bias.x = mean.acce[0];
+    calib->acce_bias.y = mean.acce[1];
+    calib->acce_bias.z = mean.acce[2] - 1.0f / calib->acce_scale.z;
+
+    if (mean.gyro_on) {
+        calib->gyro_bias.x = mean.gyro[0];
+        calib->gyro_bias.y = mean.gyro[1];
+        calib->gyro_bias.z = mean.gyro[2];
+    }
+
+    ESP_LOGI(TAG, "Bias acce %.4f %.4f %.4f g, gyro %.3f %.3f %.3f dps",
+             calib->acce_bias.x, calib->acce_bias.y, calib->acce_bias.z,
+             calib->gyro_bias.x, calib->gyro_bias.y, calib->gyro_bias.z);
+    return ESP_OK;
+}
+
+esp_err_t icm42670_calib_six_pos_capture(icm42670_handle_t sensor, icm42670_calib_six_pos_t *state,
+                                         uint16_t samples, uint32_t period_ms)
+{
+    icm42670_calib_mean_t mean;
+    int axis = 0;
+
+    assert(state != NULL);
+    ESP_RETURN_ON_ERROR(icm42670_calib_average(sensor, samples, period_ms, &mean), TAG, "Average error!");
+
+    // The axis carrying gravity is the one with the largest reading
+    for (int i = 1; i < 3; i++) {
+        if (fabsf(mean.acce[i]) > fabsf(mean.acce[axis])) {
+            axis = i;
+        }
+    }
+    float g = mean.acce[axis];
+    ESP_RETURN_ON_FALSE(fabsf(fabsf(g) - 1.0f) < CALIB_AXIS_TOLERANCE_G, ESP_ERR_INVALID_STATE, TAG,
+                        "No axis along gravity");
+
+    float *pos = &state->pos.x;
+    float *neg = &state->neg.x;
+    if (g > 0.0f) {
+        pos[axis] = g;
+        state->seen |= 1 << (2 * axis);
+    } else {
+        neg[axis] = g;
+        state->seen |= 1 << (2 * axis + 1);
+    }
+
+    ESP_LOGI(TAG, "Captured %c%c: %.4f g", g > 0.0f ? '+' : '-', 'X' + axis, g);
+    return ESP_OK;
+}
+
+bool icm42670_calib_six_pos_done(const icm42670_calib_six_pos_t *state)
+{
+    return (state->seen & CALIB_SIX_POS_ALL) == CALIB_SIX_POS_ALL;
+}
+
+esp_err_t icm42670_calib_six_pos_finish(const icm42670_calib_six_pos_t *state, icm42670_calib_t *calib)
+{
+    assert(calib != NULL);
+    ESP_RETURN_ON_FALSE(icm42670_calib_six_pos_done(state), ESP_ERR_INVALID_STATE, TAG, "Positions missing");
+
+    const float *pos = &state->pos.x;
+    const float *neg = &state->neg.x;
+    float *bias = &calib->acce_bias.x;
+    float *scale = &calib->acce_scale.x;
+
+    // Reading = 1 g / scale + bias facing up, -1 g / scale + bias facing down
+    for (int i = 0; i < 3; i++) {
+        bias[i] = (pos[i] + neg[i]) * 0.5f;
+        scale[i] = 2.0f / (pos[i] - neg[i]);
+    }
+
+    ESP_LOGI(TAG, "Scale %.4f %.4f %.4f, bias %.4f %.4f %.4f g", scale[0], scale[1], scale[2],
+             bias[0], bias[1], bias[2]);
+    return ESP_OK;
+}
+
+esp_err_t icm42670_calib_save(const char *key, const icm42670_calib_t *calib)
+{
+    esp_err_t ret = ESP_OK;
+    nvs_handle_t nvs;
+    icm42670_calib_blob_t blob = {
+        .version = CALIB_BLOB_VERSION,
+        .calib = *calib,
+    };
+
+    ESP_RETURN_ON_ERROR(nvs_open(ICM42670_CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs), TAG, "NVS open error!");
+    ESP_GOTO_ON_ERROR(nvs_set_blob(nvs, key, &blob, sizeof(blob)), err, TAG, "NVS write error!");
+    ESP_GOTO_ON_ERROR(nvs_commit(nvs), err, TAG, "NVS commit error!");
+
+err:
+    nvs_close(nvs);
+    return ret;
+}
+
+esp_err_t icm42670_calib_load(const char *key, icm42670_calib_t *calib)
+{
+    esp_err_t ret = ESP_OK;
+    nvs_handle_t nvs;
+    icm42670_calib_blob_t blob;
+    size_t len = 0;
+
+    assert(calib != NULL);
+
+    ret = nvs_open(ICM42670_CALIB_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (ret != ESP_OK) {
+        return ret;     // Namespace not created yet counts as nothing stored
+    }
+
+    ret = nvs_get_blob(nvs, key, NULL, &len);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+    ESP_GOTO_ON_FALSE(len == sizeof(blob), ESP_ERR_INVALID_VERSION, err, TAG, "Stored size %u", (unsigned) len);
+    ESP_GOTO_ON_ERROR(nvs_get_blob(nvs, key, &blob, &len), err, TAG, "NVS read error!");
+    ESP_GOTO_ON_FALSE(blob.version == CALIB_BLOB_VERSION, ESP_ERR_INVALID_VERSION, err, TAG,
+                      "Stored version %" PRIu32, blob.version);
+
+    const float *scale = &blob.calib.acce_scale.x;
+    const float *acce_bias = &blob.calib.acce_bias.x;
+    const float *gyro_bias = &blob.calib.gyro_bias.x;
+    for (int i = 0; i < 3; i++) {
+        ESP_GOTO_ON_FALSE(scale[i] > CALIB_SCALE_MIN && scale[i] < CALIB_SCALE_MAX &&
+                          isfinite(acce_bias[i]) && isfinite(gyro_bias[i]),
+                          ESP_ERR_INVALID_STATE, err, TAG, "Stored values out of range");
+    }
+
+    *calib = blob.calib;
+
+err:
+    nvs_close(nvs);
+    return ret;
+}
+
+esp_err_t icm42670_calib_load_or_estimate(icm42670_handle_t sensor, const char *key, uint16_t samples,
+                                          uint32_t period_ms, icm42670_calib_t *calib)
+{
+    icm42670_calib_t found = ICM42670_CALIB_DEFAULT();
+
+    if (icm42670_calib_load(key, &found) != ESP_OK) {
+        ESP_LOGW(TAG, "No calibration stored, keep the board flat");
+        vTaskDelay(pdMS_TO_TICKS(ICM42670_CALIB_SETTLE_MS));
+        ESP_RETURN_ON_ERROR(icm42670_calib_estimate_bias(sensor, samples, period_ms, &found), TAG, "Estimate error!");
+        if (icm42670_calib_save(key, &found) != ESP_OK) {
+            ESP_LOGW(TAG, "Calibration not saved");
+        }
+    }
+
+    ESP_RETURN_ON_ERROR(icm42670_set_calibration(sensor, &found), TAG, "Set calibration error!");
+    if (calib) {
+        *calib = found;
+    }
+    return ESP_OK;
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static esp_err_t icm42670_calib_average(icm42670_handle_t sensor, uint16_t samples, uint32_t period_ms,
+                                        icm42670_calib_mean_t *mean)
+{
+    icm42670_all_raw_value_t raw;
+    int64_t acce_sum[3] = {0};
+    int64_t gyro_sum[3] = {0};
+    float acce_sensitivity, gyro_sensitivity;
+
+    ESP_RETURN_ON_FALSE(samples > 0, ESP_ERR_INVALID_ARG, TAG, "No samples");
+
+    // Sum raw counts so the average is not limited by float precision
+    for (uint16_t n = 0; n < samples; n++) {
+        ESP_RETURN_ON_ERROR(icm42670_get_all_raw_value(sensor, &raw), TAG, "Get raw value error!");
+        ESP_RETURN_ON_FALSE(raw.acce.x != SENSOR_OFF, ESP_ERR_INVALID_STATE, TAG, "Accelerometer off");
+        acce_sum[0] += raw.acce.x;
+        acce_sum[1] += raw.acce.y;
+        acce_sum[2] += raw.acce.z;
+        gyro_sum[0] += raw.gyro.x;
+        gyro_sum[1] += raw.gyro.y;
+        gyro_sum[2] += raw.gyro.z;
+        vTaskDelay(pdMS_TO_TICKS(period_ms));
+    }
+
+    ESP_RETURN_ON_ERROR(icm42670_get_acce_sensitivity(sensor, &acce_sensitivity), TAG, "Get sensitivity error!");
+    ESP_RETURN_ON_ERROR(icm42670_get_gyro_sensitivity(sensor, &gyro_sensitivity), TAG, "Get sensitivity error!");
+
+    for (int i = 0; i < 3; i++) {
+        mean->acce[i] = (float) acce_sum[i] / samples / acce_sensitivity;
+        mean->gyro[i] = (float) gyro_sum[i] / samples / gyro_sensitivity;
+    }
+    mean->gyro_on = raw.gyro.x != SENSOR_OFF;
+    return ESP_OK;
+}
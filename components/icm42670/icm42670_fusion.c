@@ -0,0 +1,177 @@
+#include <math.h>
+#include <stdlib.h>
+#include "esp_check.h"
+#include "icm42670_fusion.h"
+
+/* atan(z) on [0, 1], Abramowitz & Stegun 4.4.49 (|error| <= 1e-5 rad), scaled to degrees */
+#define ATAN_C1     ( 0.9998660f * 57.29577951f)
+#define ATAN_C3     (-0.3302995f * 57.29577951f)
+#define ATAN_C5     ( 0.1801410f * 57.29577951f)
+#define ATAN_C7     (-0.0851330f * 57.29577951f)
+#define ATAN_C9     ( 0.0208351f * 57.29577951f)
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef struct {
+    icm42670_fusion_config_t config;
+    uint32_t timestamp_mask;
+    uint32_t last_us;
+    bool started;
+    complimentary_angle_t angle;
+} icm42670_fusion_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static void icm42670_fusion_step(icm42670_fusion_t *filter, const icm42670_value_t *acce,
+                                 const icm42670_value_t *gyro, uint32_t timestamp_us);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "ICM42670_FUSION";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t icm42670_fusion_create(const icm42670_fusion_config_t *config, icm42670_fusion_handle_t *handle_ret)
+{
+    assert(config != NULL && handle_ret != NULL);
+    ESP_RETURN_ON_FALSE(config->alpha >= 0.0f && config->alpha <= 1.0f, ESP_ERR_INVALID_ARG, TAG, "Invalid alpha");
+    ESP_RETURN_ON_FALSE(config->timestamp_bits >= 8 && config->timestamp_bits <= 32, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid timestamp width");
+
+    // dt is taken modulo the timestamp width, so a longer gap could never be seen
+    uint32_t timestamp_mask = (config->timestamp_bits == 32) ? UINT32_MAX : ((1UL << config->timestamp_bits) - 1);
+    ESP_RETURN_ON_FALSE(config->max_gap_us <= timestamp_mask, ESP_ERR_INVALID_ARG, TAG,
+                        "max_gap_us wider than the timestamps");
+
+    icm42670_fusion_t *filter = (icm42670_fusion_t *) calloc(1, sizeof(icm42670_fusion_t));
+    ESP_RETURN_ON_FALSE(filter != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+    filter->config = *config;
+    filter->timestamp_mask = timestamp_mask;
+
+    *handle_ret = filter;
+    return ESP_OK;
+}
+
+void icm42670_fusion_delete(icm42670_fusion_handle_t handle)
+{
+    free(handle);
+}
+
+void icm42670_fusion_reset(icm42670_fusion_handle_t handle)
+{
+    icm42670_fusion_t *filter = (icm42670_fusion_t *) handle;
+
+    filter->started = false;
+}
+
+void icm42670_fusion_update(icm42670_fusion_handle_t handle, const icm42670_fusion_sample_t *samples,
+                            size_t count, complimentary_angle_t *angle)
+{
+    icm42670_fusion_t *filter = (icm42670_fusion_t *) handle;
+
+    for (size_t i = 0; i < count; i++) {
+        icm42670_fusion_step(filter, &samples[i].acce, &samples[i].gyro, samples[i].timestamp_us);
+    }
+
+    if (angle) {
+        *angle = filter->angle;
+    }
+}
+
+esp_err_t icm42670_fusion_update_fifo(icm42670_fusion_handle_t handle, icm42670_handle_t sensor,
+                                      const icm42670_fifo_sample_t *samples, size_t count,
+                                      complimentary_angle_t *angle)
+{
+    icm42670_fusion_t *filter = (icm42670_fusion_t *) handle;
+    icm42670_value_t acce, gyro;
+
+    for (size_t i = 0; i < count; i++) {
+        const icm42670_fifo_sample_t *s = &samples[i];
+        if (s->acce.x == ICM42670_FIFO_INVALID || s->gyro.x == ICM42670_FIFO_INVALID) {
+            continue;
+        }
+
+        // Same sensitivity and calibration as the driver's *_value reads
+        ESP_RETURN_ON_ERROR(icm42670_acce_raw_to_value(sensor, &s->acce, &acce), TAG, "Convert error!");
+        ESP_RETURN_ON_ERROR(icm42670_gyro_raw_to_value(sensor, &s->gyro, &gyro), TAG, "Convert error!");
+        icm42670_fusion_step(filter, &acce, &gyro, s->timestamp);
+    }
+
+    if (angle) {
+        *angle = filter->angle;
+    }
+    return ESP_OK;
+}
+
+esp_err_t icm42670_fusion_get_angle(icm42670_fusion_handle_t handle, complimentary_angle_t *angle)
+{
+    icm42670_fusion_t *filter = (icm42670_fusion_t *) handle;
+
+    assert(angle != NULL);
+    ESP_RETURN_ON_FALSE(filter->started, ESP_ERR_INVALID_STATE, TAG, "No sample yet");
+
+    *angle = filter->angle;
+    return ESP_OK;
+}
+
+float icm42670_fast_atan2_deg(float y, float x)
+{
+    float abs_x = fabsf(x);
+    float abs_y = fabsf(y);
+    float hi = abs_x > abs_y ? abs_x : abs_y;
+    float lo = abs_x > abs_y ? abs_y : abs_x;
+
+    if (hi == 0.0f) {
+        return 0.0f;
+    }
+
+    // Reduce to the first octant, where the polynomial is accurate
+    float z = lo / hi;
+    float z2 = z * z;
+    float a = z * (ATAN_C1 + z2 * (ATAN_C3 + z2 * (ATAN_C5 + z2 * (ATAN_C7 + z2 * ATAN_C9))));
+
+    if (abs_y > abs_x) {
+        a = 90.0f - a;
+    }
+    if (x < 0.0f) {
+        a = 180.0f - a;
+    }
+    return (y < 0.0f) ? -a : a;
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static void icm42670_fusion_step(icm42670_fusion_t *filter, const icm42670_value_t *acce,
+                                 const icm42670_value_t *gyro, uint32_t timestamp_us)
+{
+    uint32_t dt_us = (timestamp_us - filter->last_us) & filter->timestamp_mask;
+
+    if (filter->started && dt_us == 0) {
+        return;     // Same sample seen twice
+    }
+    filter->last_us = timestamp_us;
+
+    float acce_roll = icm42670_fast_atan2_deg(acce->y, acce->z);
+    float acce_pitch = icm42670_fast_atan2_deg(acce->x, acce->z);
+
+    // First sample, or a gap the gyroscope can't bridge: trust the accelerometer
+    if (!filter->started || dt_us > filter->config.max_gap_us) {
+        filter->angle.roll = acce_roll;
+        filter->angle.pitch = acce_pitch;
+        filter->started = true;
+        return;
+    }
+
+    const float alpha = filter->config.alpha;
+    const float dt = dt_us * 1e-6f;
+    filter->angle.roll = alpha * (filter->angle.roll + gyro->x * dt) + (1.0f - alpha) * acce_roll;
+    filter->angle.pitch = alpha * (filter->angle.pitch + gyro->y * dt) + (1.0f - alpha) * acce_pitch;
+}
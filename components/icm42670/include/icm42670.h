@@ -0,0 +1,601 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+ #pragma once
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+ 
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include "sdkconfig.h"
+ #include "freertos/FreeRTOS.h"
+ #include "icm42670_types.h"
+ 
+ #if CONFIG_IDF_TARGET_LINUX
+ #include "icm42670_sim.h"
+ #else
+ #include "driver/gpio.h"
+ #include "driver/i2c_master.h"
+ #endif
+ 
+ #define ICM42670_I2C_ADDRESS         0x68 /*!< I2C address with AD0 pin low */
+ #define ICM42670_I2C_ADDRESS_1       0x69 /*!< I2C address with AD0 pin high */
+ 
+ #define ICM42670_FIFO_SIZE           2304 /*!< FIFO capacity in bytes */
+ #define ICM42670_FIFO_INVALID        (-32768) /*!< Axis value of a sensor that had no new sample */
+ 
+ typedef enum {
+     ACCE_FS_16G = 0,     /*!< Accelerometer full scale range is +/- 16g */
+     ACCE_FS_8G  = 1,     /*!< Accelerometer full scale range is +/- 8g */
+     ACCE_FS_4G  = 2,     /*!< Accelerometer full scale range is +/- 4g */
+     ACCE_FS_2G  = 3,     /*!< Accelerometer full scale range is +/- 2g */
+ } icm42670_acce_fs_t;
+ 
+ typedef enum {
+     ACCE_PWR_OFF      = 0,     /*!< Accelerometer power off state */
+     ACCE_PWR_ON       = 1,     /*!< Accelerometer power on state */
+     ACCE_PWR_LOWPOWER = 2,     /*!< Accelerometer low-power mode */
+     ACCE_PWR_LOWNOISE = 3,     /*!< Accelerometer low noise state */
+ } icm42670_acce_pwr_t;
+ 
+ typedef enum {
+     ACCE_ODR_1600HZ   = 5,  /*!< Accelerometer ODR 1.6 kHz */
+     ACCE_ODR_800HZ    = 6,  /*!< Accelerometer ODR 800 Hz */
+     ACCE_ODR_400HZ    = 7,  /*!< Accelerometer ODR 400 Hz */
+     ACCE_ODR_200HZ    = 8,  /*!< Accelerometer ODR 200 Hz */
+     ACCE_ODR_100HZ    = 9,  /*!< Accelerometer ODR 100 Hz */
+     ACCE_ODR_50HZ     = 10, /*!< Accelerometer ODR 50 Hz */
+     ACCE_ODR_25HZ     = 11, /*!< Accelerometer ODR 25 Hz */
+     ACCE_ODR_12_5HZ   = 12, /*!< Accelerometer ODR 12.5 Hz */
+     ACCE_ODR_6_25HZ   = 13, /*!< Accelerometer ODR 6.25 Hz */
+     ACCE_ODR_3_125HZ  = 14, /*!< Accelerometer ODR 3.125 Hz */
+     ACCE_ODR_1_5625HZ = 15, /*!< Accelerometer ODR 1.5625 Hz */
+ } icm42670_acce_odr_t;
+ 
+ typedef enum {
+     GYRO_FS_2000DPS = 0,     /*!< Gyroscope full scale range is +/- 2000 degree per sencond */
+     GYRO_FS_1000DPS = 1,     /*!< Gyroscope full scale range is +/- 1000 degree per sencond */
+     GYRO_FS_500DPS  = 2,     /*!< Gyroscope full scale range is +/- 500 degree per sencond */
+     GYRO_FS_250DPS  = 3,     /*!< Gyroscope full scale range is +/- 250 degree per sencond */
+ } icm42670_gyro_fs_t;
+ 
+ typedef enum {
+     GYRO_PWR_OFF      = 0,     /*!< Gyroscope power off state */
+     GYRO_PWR_STANDBY  = 1,     /*!< Gyroscope power standby state */
+     GYRO_PWR_LOWNOISE = 3,     /*!< Gyroscope power low noise state */
+ } icm42670_gyro_pwr_t;
+ 
+ typedef enum {
+     GYRO_ODR_1600HZ = 5,  /*!< Gyroscope ODR 1.6 kHz */
+     GYRO_ODR_800HZ  = 6,  /*!< Gyroscope ODR 800 Hz */
+     GYRO_ODR_400HZ  = 7,  /*!< Gyroscope ODR 400 Hz */
+     GYRO_ODR_200HZ  = 8,  /*!< Gyroscope ODR 200 Hz */
+     GYRO_ODR_100HZ  = 9,  /*!< Gyroscope ODR 100 Hz */
+     GYRO_ODR_50HZ   = 10, /*!< Gyroscope ODR 50 Hz */
+     GYRO_ODR_25HZ   = 11, /*!< Gyroscope ODR 25 Hz */
+     GYRO_ODR_12_5HZ = 12, /*!< Gyroscope ODR 12.5 Hz */
+ } icm42670_gyro_odr_t;
+ 
+ typedef struct {
+     icm42670_acce_fs_t  acce_fs;    /*!< Accelerometer full scale range */
+     icm42670_acce_odr_t acce_odr;   /*!< Accelerometer ODR selection */
+     icm42670_gyro_fs_t  gyro_fs;    /*!< Gyroscope full scale range */
+     icm42670_gyro_odr_t gyro_odr;   /*!< Gyroscope ODR selection */
+ } icm42670_cfg_t;
+ 
+ typedef enum {
+     ICM42670_FIFO_PACKET_ACCEL      = 0, /*!< 8 bytes: header, accelerometer, 8-bit temperature */
+     ICM42670_FIFO_PACKET_GYRO       = 1, /*!< 8 bytes: header, gyroscope, 8-bit temperature */
+     ICM42670_FIFO_PACKET_ACCEL_GYRO = 2, /*!< 16 bytes: header, accelerometer, gyroscope, temperature, timestamp */
+ } icm42670_fifo_packet_t;
+ 
+ typedef struct {
+     icm42670_fifo_packet_t packet;  /*!< What each FIFO record holds */
+     uint16_t watermark;             /*!< FIFO threshold, in packets; raises FIFO_THS once reached */
+     bool stop_on_full;              /*!< Drop new samples when full instead of overwriting the oldest */
+ } icm42670_fifo_cfg_t;
+ 
+ typedef struct {
+     uint8_t header;             /*!< Raw FIFO packet header */
+     icm42670_raw_value_t acce;  /*!< ICM42670_FIFO_INVALID on every axis if not in the packet */
+     icm42670_raw_value_t gyro;  /*!< ICM42670_FIFO_INVALID on every axis if not in the packet */
+     int16_t temp;               /*!< Same scale as icm42670_get_temp_raw_value() */
+     uint16_t timestamp;         /*!< Sensor timestamp in us, wraps at 16 bits; 0 if not in the packet */
+ } icm42670_fifo_sample_t;
+ 
+ typedef enum {
+     ICM42670_INT_DATA_READY = 0, /*!< A new sample is in the data registers */
+     ICM42670_INT_FIFO_THS   = 1, /*!< FIFO reached the watermark set by icm42670_fifo_config() */
+     ICM42670_INT_APEX       = 2, /*!< Events enabled by icm42670_apex_config() */
+ } icm42670_int_source_t;
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+ typedef struct {
+     gpio_num_t gpio;                /*!< GPIO wired to the sensor's INT1 pin */
+     icm42670_int_source_t source;   /*!< Event that pulses INT1 */
+ } icm42670_int_cfg_t;
+ #endif
+ 
+ typedef enum {
+     ICM42670_APEX_WOM       = (1 << 0), /*!< Wake-on-motion: any axis moved past the threshold */
+     ICM42670_APEX_TILT      = (1 << 1), /*!< Held tilted by more than 35 degrees for about 4 s */
+     ICM42670_APEX_PEDOMETER = (1 << 2), /*!< Step detected */
+ } icm42670_apex_feature_t;
+ 
+ typedef struct {
+     uint32_t features;          /*!< ICM42670_APEX_* flags; 0 turns every engine off */
+     uint8_t wom_threshold;      /*!< Wake-on-motion threshold per axis, 1/256 g per LSB */
+     bool wom_vs_previous;       /*!< Compare with the previous sample instead of the first one after enabling */
+ } icm42670_apex_cfg_t;
+ 
+ #if CONFIG_IDF_TARGET_LINUX
+ typedef icm42670_sim_handle_t icm42670_bus_handle_t;    /*!< Simulated bus on the host build */
+ #else
+ typedef i2c_master_bus_handle_t icm42670_bus_handle_t;  /*!< I2C bus, from i2c_new_master_bus() */
+ #endif
+ 
+ typedef void *icm42670_handle_t;
+ 
+ /**
+  * @brief Create and init sensor object
+  *
+  * @param[in]  i2c_bus    I2C bus handle. Obtained from i2c_new_master_bus(), or icm42670_sim_create() on linux
+  * @param[in]  dev_addr   I2C device address of sensor. Can be ICM42670_I2C_ADDRESS or ICM42670_I2C_ADDRESS_1
+  * @param[out] handle_ret Handle to created ICM42670 driver object
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_ERR_NO_MEM Not enough memory for the driver
+  *     - ESP_ERR_NOT_FOUND Sensor not found on the I2C bus
+  *     - Others Error from underlying I2C driver
+  */
+ esp_err_t icm42670_create(icm42670_bus_handle_t i2c_bus, const uint8_t dev_addr, icm42670_handle_t *handle_ret);
+ 
+ /**
+  * @brief Delete and release a sensor object
+  *
+  * @param sensor object handle of icm42670
+  */
+ void icm42670_delete(icm42670_handle_t sensor);
+ 
+ /**
+  * @brief Get device identification of ICM42670
+  *
+  * @param sensor object handle of icm42670
+  * @param deviceid a pointer of device ID
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_deviceid(icm42670_handle_t sensor, uint8_t *deviceid);
+ 
+ /**
+  * @brief Set accelerometer power mode
+  *
+  * @param sensor object handle of icm42670
+  * @param state power mode of accelerometer
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_acce_set_pwr(icm42670_handle_t sensor, icm42670_acce_pwr_t state);
+ 
+ /**
+  * @brief Set gyroscope power mode
+  *
+  * @param sensor object handle of icm42670
+  * @param state power mode of gyroscope
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_gyro_set_pwr(icm42670_handle_t sensor, icm42670_gyro_pwr_t state);
+ 
+ /**
+  * @brief Set accelerometer and gyroscope full scale range
+  *
+  * @param sensor object handle of icm42670
+  * @param config Accelerometer and gyroscope configuration structure
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_config(icm42670_handle_t sensor, const icm42670_cfg_t *config);
+ 
+ /**
+  * @brief Get accelerometer sensitivity
+  *
+  * Served from the full-scale range cached at create time and by icm42670_config(); no bus access.
+  *
+  * @param sensor object handle of icm42670
+  * @param sensitivity accelerometer sensitivity
+  *
+  * @return
+  *     - ESP_OK Success
+  */
+ esp_err_t icm42670_get_acce_sensitivity(icm42670_handle_t sensor, float *sensitivity);
+ 
+ /**
+  * @brief Get gyroscope sensitivity
+  *
+  * Served from the full-scale range cached at create time and by icm42670_config(); no bus access.
+  *
+  * @param sensor object handle of icm42670
+  * @param sensitivity gyroscope sensitivity
+  *
+  * @return
+  *     - ESP_OK Success
+  */
+ esp_err_t icm42670_get_gyro_sensitivity(icm42670_handle_t sensor, float *sensitivity);
+ 
+ /**
+  * @brief Set the bias and scale corrections applied by the *_value reads
+  *
+  * Sensitivity and calibration are folded into one gain and offset per axis
+  * here, so a corrected read costs the same as an uncorrected one. Raw reads
+  * stay uncorrected.
+  *
+  * @param sensor object handle of icm42670
+  * @param calib corrections, e.g. from icm42670_calib_load()
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_ERR_INVALID_ARG Scale not positive
+  */
+ esp_err_t icm42670_set_calibration(icm42670_handle_t sensor, const icm42670_calib_t *calib);
+ 
+ /**
+  * @brief Get the corrections in use
+  *
+  * @param sensor object handle of icm42670
+  * @param calib corrections
+  *
+  * @return
+  *     - ESP_OK Success
+  */
+ esp_err_t icm42670_get_calibration(icm42670_handle_t sensor, icm42670_calib_t *calib);
+ 
+ /**
+  * @brief Convert raw accelerometer counts, e.g. from the FIFO, to calibrated g
+  *
+  * @param sensor object handle of icm42670
+  * @param raw raw accelerometer measurements
+  * @param value accelerometer measurements in g
+  *
+  * @return
+  *     - ESP_OK Success
+  */
+ esp_err_t icm42670_acce_raw_to_value(icm42670_handle_t sensor, const icm42670_raw_value_t *raw, icm42670_value_t *value);
+ 
+ /**
+  * @brief Convert raw gyroscope counts, e.g. from the FIFO, to calibrated dps
+  *
+  * @param sensor object handle of icm42670
+  * @param raw raw gyroscope measurements
+  * @param value gyroscope measurements in dps
+  *
+  * @return
+  *     - ESP_OK Success
+  */
+ esp_err_t icm42670_gyro_raw_to_value(icm42670_handle_t sensor, const icm42670_raw_value_t *raw, icm42670_value_t *value);
+ 
+ /**
+  * @brief Read raw temperature measurements
+  *
+  * @param sensor object handle of icm42670
+  * @param value raw temperature measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_temp_raw_value(icm42670_handle_t sensor, uint16_t *value);
+ 
+ /**
+  * @brief Read raw accelerometer measurements
+  *
+  * @param sensor object handle of icm42670
+  * @param value raw accelerometer measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_acce_raw_value(icm42670_handle_t sensor, icm42670_raw_value_t *value);
+ 
+ /**
+  * @brief Read raw gyroscope measurements
+  *
+  * @param sensor object handle of icm42670
+  * @param value raw gyroscope measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_gyro_raw_value(icm42670_handle_t sensor, icm42670_raw_value_t *value);
+ 
+ /**
+  * @brief Read raw temperature, accelerometer and gyroscope measurements in one burst
+  *
+  * TEMP_DATA, ACCEL_DATA and GYRO_DATA are contiguous, so all three come from a
+  * single 14-byte read and belong to the same sample.
+  *
+  * @param sensor object handle of icm42670
+  * @param value raw measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_all_raw_value(icm42670_handle_t sensor, icm42670_all_raw_value_t *value);
+ 
+ /**
+  * @brief Read accelerometer measurements
+  *
+  * @param sensor object handle of icm42670
+  * @param value accelerometer measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_acce_value(icm42670_handle_t sensor, icm42670_value_t *value);
+ 
+ /**
+  * @brief Read gyro values
+  *
+  * @param sensor object handle of icm42670
+  * @param value gyroscope measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_gyro_value(icm42670_handle_t sensor, icm42670_value_t *value);
+ 
+ /**
+  * @brief Read temperature, accelerometer and gyroscope values in one burst
+  *
+  * @param sensor object handle of icm42670
+  * @param value scaled measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_all_value(icm42670_handle_t sensor, icm42670_all_value_t *value);
+ 
+ /**
+  * @brief Read temperature value
+  *
+  * @param sensor object handle of icm42670
+  * @param value temperature measurements
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_get_temp_value(icm42670_handle_t sensor, float *value);
+ 
+ /**
+  * @brief Configure and start the FIFO
+  *
+  * The FIFO is bypassed and flushed while it is reconfigured, so samples queued
+  * before the call are lost. Counts and the watermark are kept in packets.
+  * The sensors that feed the packet must be powered on first.
+  *
+  * Part of the setup lives in MREG1, which the sensor only writes while its
+  * internal clock (MCLK) runs. That is the case with either sensor on; if both
+  * are off, PWR_MGMT0.IDLE is set for the access and cleared again.
+  *
+  * @param sensor object handle of icm42670
+  * @param config FIFO configuration
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_ERR_INVALID_ARG Unknown packet format or watermark larger than the FIFO
+  *     - ESP_ERR_INVALID_STATE Internal clock did not start
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_fifo_config(icm42670_handle_t sensor, const icm42670_fifo_cfg_t *config);
+ 
+ /**
+  * @brief Put the FIFO back in bypass mode
+  *
+  * @param sensor object handle of icm42670
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_fifo_disable(icm42670_handle_t sensor);
+ 
+ /**
+  * @brief Discard everything queued in the FIFO
+  *
+  * @param sensor object handle of icm42670
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_fifo_flush(icm42670_handle_t sensor);
+ 
+ /**
+  * @brief Get the number of complete packets in the FIFO
+  *
+  * @param sensor object handle of icm42670
+  * @param count number of packets
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_fifo_get_count(icm42670_handle_t sensor, uint16_t *count);
+ 
+ /**
+  * @brief Drain up to max_samples packets from the FIFO
+  *
+  * Reads the packet count, then every available packet (up to max_samples) in
+  * a single burst. The raw bytes are read into the samples array and decoded in
+  * place, so no buffer is allocated.
+  *
+  * @param sensor object handle of icm42670
+  * @param samples caller-provided array of at least max_samples entries
+  * @param max_samples capacity of samples
+  * @param count number of samples decoded
+  *
+  * @return
+  *     - ESP_OK Success, also when the FIFO was empty
+  *     - ESP_ERR_INVALID_STATE FIFO not configured
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_fifo_read(icm42670_handle_t sensor, icm42670_fifo_sample_t *samples, size_t max_samples, size_t *count);
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+ /**
+  * @brief Drive INT1 from the sensor and catch it with a GPIO interrupt
+  *
+  * INT1 is set up push-pull, active high and pulsed, so nothing has to be
+  * acknowledged over I2C. The ISR timestamps each pulse with esp_timer and
+  * notifies the task blocked in icm42670_int_wait(). Installs the GPIO ISR
+  * service if nobody has yet.
+  *
+  * INT1 carries one source at a time. Calling again with the same pin only
+  * switches the source, e.g. from data-ready to wake-on-motion while idle.
+  *
+  * @param sensor object handle of icm42670
+  * @param config INT1 pin and source
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_ERR_INVALID_ARG Invalid pin or source
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_int_enable(icm42670_handle_t sensor, const icm42670_int_cfg_t *config);
+ 
+ /**
+  * @brief Stop INT1 and remove the GPIO interrupt handler
+  *
+  * @param sensor object handle of icm42670
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_int_disable(icm42670_handle_t sensor);
+ 
+ /**
+  * @brief Block until the next INT1 pulse
+  *
+  * Uses the calling task's notification value, and only one task may wait
+  * on a sensor. A pulse that arrived since the previous call returns at once;
+  * if several did, the timestamp is that of the latest.
+  *
+  * @param sensor object handle of icm42670
+  * @param timeout ticks to wait
+  * @param timestamp_us esp_timer_get_time() at the pulse, may be NULL
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_ERR_TIMEOUT No pulse within timeout
+  *     - ESP_ERR_INVALID_STATE Interrupt not enabled
+  */
+ esp_err_t icm42670_int_wait(icm42670_handle_t sensor, TickType_t timeout, int64_t *timestamp_us);
+ #endif
+ 
+ /**
+  * @brief Set up the on-chip motion engines
+  *
+  * Wake-on-motion runs on the accelerometer samples at their ODR; tilt and
+  * the pedometer run on the DMP, which needs an accelerometer ODR of 25, 50,
+  * 100 or 400 Hz. The accelerometer has to be powered in either case. Events
+  * reach INT1 while it is set to ICM42670_INT_APEX; the engines run and latch
+  * their status whatever INT1 carries.
+  *
+  * The wake-on-motion thresholds live in MREG1, which the sensor only writes
+  * while its internal clock (MCLK) runs; with the accelerometer on, as
+  * required here, it does.
+  *
+  * @param sensor object handle of icm42670
+  * @param config engines to run and the wake-on-motion threshold
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_ERR_INVALID_ARG Unknown feature flag
+  *     - ESP_ERR_INVALID_STATE Accelerometer ODR the DMP can't run at
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_apex_config(icm42670_handle_t sensor, const icm42670_apex_cfg_t *config);
+ 
+ /**
+  * @brief Read and clear the APEX events latched since the last call
+  *
+  * @param sensor object handle of icm42670
+  * @param events ICM42670_APEX_* flags of the engines that fired
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_apex_get_events(icm42670_handle_t sensor, uint32_t *events);
+ 
+ /**
+  * @brief Read the pedometer step count
+  *
+  * @param sensor object handle of icm42670
+  * @param steps steps since the pedometer was enabled, wraps at 16 bits
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_apex_get_step_count(icm42670_handle_t sensor, uint16_t *steps);
+ 
+ #if !CONFIG_IDF_TARGET_LINUX
+ /**
+  * @brief Block until wake-on-motion fires
+  *
+  * Points INT1 at the APEX events, drops any already latched, and waits for
+  * a pulse that carries wake-on-motion. INT1 goes back to the source it had
+  * before, whether motion came or not. The task sleeps throughout.
+  *
+  * @param sensor object handle of icm42670, with INT1 enabled and ICM42670_APEX_WOM configured
+  * @param timeout ticks to wait in total
+  *
+  * @return
+  *     - ESP_OK Motion
+  *     - ESP_ERR_TIMEOUT No motion within timeout
+  *     - ESP_ERR_INVALID_STATE Interrupt or wake-on-motion not enabled
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_apex_wait_motion(icm42670_handle_t sensor, TickType_t timeout);
+ #endif
+ 
+ /**
+  * @brief use complimentory filter to caculate roll and pitch
+  *
+  * @param acce_value accelerometer measurements
+  * @param gyro_value gyroscope measurements
+  * @param complimentary_angle complimentary angle
+  *
+  * @return
+  *     - ESP_OK Success
+  *     - ESP_FAIL Fail
+  */
+ esp_err_t icm42670_complimentory_filter(icm42670_handle_t sensor, const icm42670_value_t *acce_value,
+                                         const icm42670_value_t *gyro_value, complimentary_angle_t *complimentary_angle);
+ 
+ #ifdef __cplusplus
+ }
+ #endif
\ No newline at end of file
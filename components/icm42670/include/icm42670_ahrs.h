@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "icm42670_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Quaternion orientation from the accelerometer and gyroscope, with the
+ * Madgwick (gradient descent) or Mahony (PI feedback) correction. Unlike the
+ * complementary filter it has no trouble at +/-90 degrees pitch. Yaw still
+ * drifts with gyroscope bias since there is no magnetometer; Mahony's
+ * integral term removes most of the bias on roll and pitch.
+ *
+ * Steps are fixed at 1 / sample_rate_hz, which suits data-ready or FIFO
+ * sampling at the sensor's ODR. No I/O, so it runs the same on the linux
+ * target against recorded traces.
+ */
+
+typedef enum {
+    ICM42670_AHRS_MADGWICK = 0,
+    ICM42670_AHRS_MAHONY   = 1,
+} icm42670_ahrs_algorithm_t;
+
+typedef struct {
+    icm42670_ahrs_algorithm_t algorithm;
+    float sample_rate_hz;       /*!< Step rate; should match the ODR */
+    float beta;                 /*!< Madgwick gain, rad/s of correction per unit error */
+    float kp;                   /*!< Mahony proportional gain */
+    float ki;                   /*!< Mahony integral gain, 0 to disable bias estimation */
+    float acce_reject_g;        /*!< Skip the correction when |acce| is off 1 g by more than this; 0 never skips */
+} icm42670_ahrs_config_t;
+
+#define ICM42670_AHRS_CONFIG_DEFAULT() {    \
+    .algorithm = ICM42670_AHRS_MADGWICK,    \
+    .sample_rate_hz = 400.0f,               \
+    .beta = 0.1f,                           \
+    .kp = 1.0f,                             \
+    .ki = 0.02f,                            \
+    .acce_reject_g = 0.2f,                  \
+}
+
+typedef struct {
+    float w;
+    float x;
+    float y;
+    float z;
+} icm42670_quaternion_t;
+
+typedef struct {
+    float roll;                 /*!< Degrees about X */
+    float pitch;                /*!< Degrees about Y, +/-90 */
+    float yaw;                  /*!< Degrees about Z, relative to the start */
+} icm42670_euler_t;
+
+typedef void *icm42670_ahrs_handle_t;
+
+/**
+ * @brief Create an AHRS engine
+ *
+ * @param config Algorithm, rate and gains
+ * @param handle_ret Handle to the created engine
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Invalid algorithm or rate
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t icm42670_ahrs_create(const icm42670_ahrs_config_t *config, icm42670_ahrs_handle_t *handle_ret);
+
+/**
+ * @brief Delete an AHRS engine
+ *
+ * @param handle Engine handle
+ */
+void icm42670_ahrs_delete(icm42670_ahrs_handle_t handle);
+
+/**
+ * @brief Change the gains without losing the orientation
+ *
+ * algorithm and sample_rate_hz are taken from config as well.
+ *
+ * @param handle Engine handle
+ * @param config New settings
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Invalid algorithm or rate
+ */
+esp_err_t icm42670_ahrs_set_config(icm42670_ahrs_handle_t handle, const icm42670_ahrs_config_t *config);
+
+/**
+ * @brief Forget the orientation; the next step starts from the accelerometer
+ *
+ * @param handle Engine handle
+ */
+void icm42670_ahrs_reset(icm42670_ahrs_handle_t handle);
+
+/**
+ * @brief Advance one step
+ *
+ * The first step after create or reset sets roll and pitch straight from
+ * the accelerometer, with yaw 0.
+ *
+ * @param handle Engine handle
+ * @param acce Accelerometer measurements in g
+ * @param gyro Gyroscope measurements in dps
+ */
+void icm42670_ahrs_update(icm42670_ahrs_handle_t handle, const icm42670_value_t *acce, const icm42670_value_t *gyro);
+
+/**
+ * @brief Advance one step per sample, e.g. on icm42670_get_all_value() readings
+ *
+ * @param handle Engine handle
+ * @param samples Samples, oldest first
+ * @param count Number of samples
+ */
+void icm42670_ahrs_update_batch(icm42670_ahrs_handle_t handle, const icm42670_all_value_t *samples, size_t count);
+
+/**
+ * @brief Get the orientation, sensor frame to world frame
+ *
+ * @param handle Engine handle
+ * @param q Unit quaternion
+ */
+void icm42670_ahrs_get_quaternion(icm42670_ahrs_handle_t handle, icm42670_quaternion_t *q);
+
+/**
+ * @brief Get the orientation as ZYX Euler angles
+ *
+ * @param handle Engine handle
+ * @param euler Angles in degrees
+ */
+void icm42670_ahrs_get_euler(icm42670_ahrs_handle_t handle, icm42670_euler_t *euler);
+
+/**
+ * @brief Get the gravity direction in the sensor frame
+ *
+ * @param handle Engine handle
+ * @param gravity Unit vector, in g
+ */
+void icm42670_ahrs_get_gravity(icm42670_ahrs_handle_t handle, icm42670_value_t *gravity);
+
+/**
+ * @brief Get the last accelerometer reading with gravity removed
+ *
+ * @param handle Engine handle
+ * @param linear Linear acceleration in the sensor frame, in g
+ */
+void icm42670_ahrs_get_linear_acce(icm42670_ahrs_handle_t handle, icm42670_value_t *linear);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "icm42670.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Estimates the corrections applied through icm42670_set_calibration() and
+ * keeps them in NVS, so each board is calibrated once rather than on every
+ * boot. Bias comes from holding the board still and flat; scale needs the
+ * six-position routine, which puts each axis straight up and straight down.
+ *
+ * nvs_flash_init() must have been called before save or load.
+ */
+
+#define ICM42670_CALIB_NVS_NAMESPACE    "icm42670"
+#define ICM42670_CALIB_NVS_KEY          "calib"
+#define ICM42670_CALIB_SETTLE_MS        1000    /*!< Time to put the board down before a first-boot estimate */
+
+typedef struct {
+    icm42670_value_t pos;       /*!< Per-axis reading with that axis pointing up, in g */
+    icm42670_value_t neg;       /*!< Per-axis reading with that axis pointing down, in g */
+    uint8_t seen;               /*!< Bit 2*axis set once pos is captured, bit 2*axis+1 for neg */
+} icm42670_calib_six_pos_t;
+
+/**
+ * @brief Estimate accelerometer and gyroscope bias with the board at rest
+ *
+ * The board must be flat with Z up and not moving. The accelerometer bias is
+ * the mean reading minus 1 g on Z; acce_scale is left as it is in calib, so
+ * calib should hold the result of a six-position run or ICM42670_CALIB_DEFAULT().
+ * Gyroscope bias is left untouched if the gyroscope is off.
+ *
+ * @param sensor object handle of icm42670, with the accelerometer on
+ * @param samples Number of samples to average
+ * @param period_ms Delay between samples; at least the ODR period
+ * @param calib Updated with the estimated bias
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG samples is 0
+ *     - ESP_ERR_INVALID_STATE Accelerometer is off
+ *     - ESP_FAIL Read error
+ */
+esp_err_t icm42670_calib_estimate_bias(icm42670_handle_t sensor, uint16_t samples, uint32_t period_ms,
+                                       icm42670_calib_t *calib);
+
+/**
+ * @brief Average one still position for the six-position routine
+ *
+ * Call once per orientation, in any order, with one axis pointing straight
+ * up or down each time. The axis and direction are taken from the reading.
+ *
+ * @param sensor object handle of icm42670, with the accelerometer on
+ * @param state Routine state, zeroed before the first capture
+ * @param samples Number of samples to average
+ * @param period_ms Delay between samples
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG samples is 0
+ *     - ESP_ERR_INVALID_STATE No axis within 0.25 g of +/-1 g; the board is not square
+ *     - ESP_FAIL Read error
+ */
+esp_err_t icm42670_calib_six_pos_capture(icm42670_handle_t sensor, icm42670_calib_six_pos_t *state,
+                                         uint16_t samples, uint32_t period_ms);
+
+/**
+ * @brief Check whether all six positions have been captured
+ *
+ * @param state Routine state
+ *
+ * @return true once every axis has been seen up and down
+ */
+bool icm42670_calib_six_pos_done(const icm42670_calib_six_pos_t *state);
+
+/**
+ * @brief Work out accelerometer bias and scale from the six positions
+ *
+ * Gyroscope bias in calib is left as it is.
+ *
+ * @param state Routine state with all six positions captured
+ * @param calib Updated with acce_bias and acce_scale
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Positions missing
+ */
+esp_err_t icm42670_calib_six_pos_finish(const icm42670_calib_six_pos_t *state, icm42670_calib_t *calib);
+
+/**
+ * @brief Store corrections in NVS
+ *
+ * @param key NVS key, e.g. ICM42670_CALIB_NVS_KEY
+ * @param calib Corrections
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - Others NVS error
+ */
+esp_err_t icm42670_calib_save(const char *key, const icm42670_calib_t *calib);
+
+/**
+ * @brief Load corrections stored by icm42670_calib_save()
+ *
+ * @param key NVS key, e.g. ICM42670_CALIB_NVS_KEY
+ * @param calib Corrections; left untouched on error
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NVS_NOT_FOUND Nothing stored yet
+ *     - ESP_ERR_INVALID_VERSION Stored by an incompatible version
+ *     - ESP_ERR_INVALID_STATE Stored values out of range
+ *     - Others NVS error
+ */
+esp_err_t icm42670_calib_load(const char *key, icm42670_calib_t *calib);
+
+/**
+ * @brief Apply stored corrections, or calibrate the bias on first boot
+ *
+ * Loads the corrections under key. If there are none, or they can't be used,
+ * waits ICM42670_CALIB_SETTLE_MS for the board to be put down flat, runs
+ * icm42670_calib_estimate_bias() from ICM42670_CALIB_DEFAULT() and stores the
+ * result; a failed store is only logged. Either way the corrections are passed
+ * to icm42670_set_calibration().
+ *
+ * @param sensor object handle of icm42670, with the accelerometer on
+ * @param key NVS key, e.g. ICM42670_CALIB_NVS_KEY
+ * @param samples Number of samples to average if the bias has to be estimated
+ * @param period_ms Delay between samples; at least the ODR period
+ * @param calib Corrections applied, may be NULL
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - Others Error from icm42670_calib_estimate_bias() or icm42670_set_calibration()
+ */
+esp_err_t icm42670_calib_load_or_estimate(icm42670_handle_t sensor, const char *key, uint16_t samples,
+                                          uint32_t period_ms, icm42670_calib_t *calib);
+
+#ifdef __cplusplus
+}
+#endif
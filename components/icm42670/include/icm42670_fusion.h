@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "icm42670.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Complementary filter for roll and pitch, stepped on the sensor's own sample
+ * times instead of the time the task got round to it. Feed it whole batches
+ * (a FIFO drain, or samples stamped by icm42670_int_wait()); each call walks
+ * the array once with float-only math and a polynomial atan2.
+ */
+
+typedef struct {
+    float alpha;                /*!< Gyroscope weight per step, 0..1 */
+    uint8_t timestamp_bits;     /*!< Width of the sample timestamps: 16 for FIFO packets, 32 for esp_timer */
+    uint32_t max_gap_us;        /*!< A longer gap between samples restarts from the accelerometer; at most
+                                     the timestamp range, e.g. 65535 with timestamp_bits = 16 */
+} icm42670_fusion_config_t;
+
+#define ICM42670_FUSION_CONFIG_DEFAULT() {  \
+    .alpha = 0.98f,                         \
+    .timestamp_bits = 32,                   \
+    .max_gap_us = 100000,                   \
+}
+
+typedef struct {
+    icm42670_value_t acce;      /*!< Accelerometer measurements in g */
+    icm42670_value_t gyro;      /*!< Gyroscope measurements in dps */
+    uint32_t timestamp_us;      /*!< Sample time; only differences are used, so it may wrap */
+} icm42670_fusion_sample_t;
+
+typedef void *icm42670_fusion_handle_t;
+
+/**
+ * @brief Create a filter
+ *
+ * @param config Filter settings
+ * @param handle_ret Handle to the created filter
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG alpha or timestamp_bits out of range, or max_gap_us past the timestamp range
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t icm42670_fusion_create(const icm42670_fusion_config_t *config, icm42670_fusion_handle_t *handle_ret);
+
+/**
+ * @brief Delete a filter
+ *
+ * @param handle Filter handle
+ */
+void icm42670_fusion_delete(icm42670_fusion_handle_t handle);
+
+/**
+ * @brief Forget the angle; the next sample starts again from the accelerometer
+ *
+ * @param handle Filter handle
+ */
+void icm42670_fusion_reset(icm42670_fusion_handle_t handle);
+
+/**
+ * @brief Run a batch of samples through the filter
+ *
+ * Samples must be in time order. dt comes from consecutive timestamps, so
+ * scheduling delays before the call don't change the result.
+ *
+ * @param handle Filter handle
+ * @param samples Samples, oldest first
+ * @param count Number of samples
+ * @param angle Angle after the last sample, in degrees; may be NULL
+ */
+void icm42670_fusion_update(icm42670_fusion_handle_t handle, const icm42670_fusion_sample_t *samples,
+                            size_t count, complimentary_angle_t *angle);
+
+/**
+ * @brief Run a batch straight from icm42670_fifo_read()
+ *
+ * Needs ICM42670_FIFO_PACKET_ACCEL_GYRO packets, which carry the sensor's
+ * 16-bit timestamp, and a filter created with timestamp_bits = 16 and so
+ * max_gap_us of 65535 or less: the timestamps wrap every 65.536 ms, so a
+ * longer gap only shows modulo that. Packets missing either sensor are skipped.
+ *
+ * @param handle Filter handle
+ * @param sensor Sensor the samples came from, for its full-scale factors and calibration
+ * @param samples FIFO samples, oldest first
+ * @param count Number of samples
+ * @param angle Angle after the last sample, in degrees; may be NULL
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Conversion failed
+ */
+esp_err_t icm42670_fusion_update_fifo(icm42670_fusion_handle_t handle, icm42670_handle_t sensor,
+                                      const icm42670_fifo_sample_t *samples, size_t count,
+                                      complimentary_angle_t *angle);
+
+/**
+ * @brief Get the current angle
+ *
+ * @param handle Filter handle
+ * @param angle Angle in degrees
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE No sample yet
+ */
+esp_err_t icm42670_fusion_get_angle(icm42670_fusion_handle_t handle, complimentary_angle_t *angle);
+
+/**
+ * @brief atan2 in degrees, float only
+ *
+ * Octant reduction plus an odd polynomial; the error is below 0.001 degrees
+ * everywhere. atan2(0, 0) returns 0.
+ */
+float icm42670_fast_atan2_deg(float y, float x);
+
+#ifdef __cplusplus
+}
+#endif
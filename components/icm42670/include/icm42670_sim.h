@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "icm42670_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Simulated ICM42670 on a simulated I2C bus, used by the linux target build.
+ * It holds the bank 0 and MREG1 register maps and a FIFO the test fills with
+ * raw packet bytes. MREG1 writes are dropped while MCLK is off, as on the chip,
+ * and the self-clearing reset bits read back as 0.
+ */
+
+typedef struct {
+    uint32_t transactions;  /*!< Write and write-read transfers addressed to the sensor */
+    uint32_t bytes_written; /*!< Bytes written, register addresses included */
+    uint32_t bytes_read;    /*!< Bytes read */
+    uint32_t nacks;         /*!< Transfers the sensor did not acknowledge */
+} icm42670_sim_stats_t;
+
+typedef struct icm42670_sim_t *icm42670_sim_handle_t;
+
+/**
+ * @brief Create a simulated bus with one ICM42670 at ICM42670_I2C_ADDRESS
+ *
+ * Registers start at their reset values: both sensors off, FIFO bypassed.
+ *
+ * @param[out] sim_ret handle to the simulated bus
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t icm42670_sim_create(icm42670_sim_handle_t *sim_ret);
+
+/**
+ * @brief Delete a simulated bus
+ */
+void icm42670_sim_delete(icm42670_sim_handle_t sim);
+
+/**
+ * @brief Get a bank 0 register as the sensor holds it
+ */
+uint8_t icm42670_sim_get_reg(icm42670_sim_handle_t sim, uint8_t reg);
+
+/**
+ * @brief Set a bank 0 register behind the driver's back, e.g. an output register
+ */
+void icm42670_sim_set_reg(icm42670_sim_handle_t sim, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Set what the temperature, accelerometer and gyroscope registers hold
+ *
+ * A sensor that PWR_MGMT0 has off reads -32768 on every axis, as on the chip.
+ */
+void icm42670_sim_set_data(icm42670_sim_handle_t sim, const icm42670_all_raw_value_t *raw);
+
+/**
+ * @brief Get an MREG1 register as the sensor holds it
+ */
+uint8_t icm42670_sim_get_mreg1(icm42670_sim_handle_t sim, uint8_t reg);
+
+/**
+ * @brief Append raw bytes to the FIFO
+ *
+ * FIFO_COUNT reports whole records of the format MREG1 FIFO_CONFIG5 selects.
+ * Reads past the end of the FIFO return 0xFF, whose top bit flags an empty
+ * packet header.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NO_MEM More than the FIFO holds
+ */
+esp_err_t icm42670_sim_fifo_push(icm42670_sim_handle_t sim, const uint8_t *data, size_t len);
+
+/**
+ * @brief Make the next @p count transfers fail with a NACK
+ */
+void icm42670_sim_inject_nack(icm42670_sim_handle_t sim, uint32_t count);
+
+/**
+ * @brief Get the bus statistics accumulated so far
+ */
+void icm42670_sim_get_stats(icm42670_sim_handle_t sim, icm42670_sim_stats_t *stats);
+
+/**
+ * @brief Zero the bus statistics
+ */
+void icm42670_sim_reset_stats(icm42670_sim_handle_t sim);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Plain measurement and angle types, with no driver includes, so the
+ * fusion and AHRS code builds for the linux target as well as a chip.
+ */
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} icm42670_raw_value_t;
+
+typedef struct {
+    float x;
+    float y;
+    float z;
+} icm42670_value_t;
+
+typedef struct {
+    icm42670_raw_value_t acce;  /*!< Raw accelerometer measurements */
+    icm42670_raw_value_t gyro;  /*!< Raw gyroscope measurements */
+    int16_t temp;               /*!< Raw temperature, 128 LSB/C around 25 C */
+} icm42670_all_raw_value_t;
+
+typedef struct {
+    icm42670_value_t acce;      /*!< Accelerometer measurements in g */
+    icm42670_value_t gyro;      /*!< Gyroscope measurements in dps */
+    float temp;                 /*!< Temperature in C */
+} icm42670_all_value_t;
+
+typedef struct {
+    icm42670_value_t acce_bias;     /*!< Accelerometer zero offset in g, removed before scaling */
+    icm42670_value_t acce_scale;    /*!< Accelerometer gain per axis, 1 when uncalibrated */
+    icm42670_value_t gyro_bias;     /*!< Gyroscope zero offset in dps */
+} icm42670_calib_t;
+
+#define ICM42670_CALIB_DEFAULT() {                  \
+    .acce_bias = {0.0f, 0.0f, 0.0f},                \
+    .acce_scale = {1.0f, 1.0f, 1.0f},               \
+    .gyro_bias = {0.0f, 0.0f, 0.0f},                \
+}
+
+typedef struct {
+    float roll;
+    float pitch;
+} complimentary_angle_t;
+
+#ifdef __cplusplus
+}
+#endif
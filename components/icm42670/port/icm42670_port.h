@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "icm42670.h"
+
+/*
+ * Bus glue between the ICM42670 driver and the transport it runs on.
+ * icm42670_port_i2c.c talks to the I2C master driver, icm42670_port_sim.c to
+ * the simulated register map used by the linux target build.
+ */
+
+typedef void *icm42670_port_dev_t;
+
+esp_err_t icm42670_port_add_device(icm42670_bus_handle_t bus, uint8_t dev_addr, icm42670_port_dev_t *dev_ret);
+void icm42670_port_rm_device(icm42670_port_dev_t dev);
+esp_err_t icm42670_port_write(icm42670_port_dev_t dev, const uint8_t *data, size_t len);
+esp_err_t icm42670_port_write_read(icm42670_port_dev_t dev, const uint8_t *write_data, size_t write_len,
+                                   uint8_t *read_data, size_t read_len);
+void icm42670_port_delay_us(uint32_t us);
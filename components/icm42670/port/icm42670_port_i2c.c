@@ -0,0 +1,35 @@
+#include "driver/i2c_master.h"
+#include "esp_rom_sys.h"
+#include "icm42670_port.h"
+
+#define ICM42670_I2C_CLK_SPEED  400000
+
+esp_err_t icm42670_port_add_device(icm42670_bus_handle_t bus, uint8_t dev_addr, icm42670_port_dev_t *dev_ret)
+{
+    const i2c_device_config_t i2c_dev_cfg = {
+        .device_address = dev_addr,
+        .scl_speed_hz = ICM42670_I2C_CLK_SPEED,
+    };
+    return i2c_master_bus_add_device(bus, &i2c_dev_cfg, (i2c_master_dev_handle_t *) dev_ret);
+}
+
+void icm42670_port_rm_device(icm42670_port_dev_t dev)
+{
+    i2c_master_bus_rm_device(dev);
+}
+
+esp_err_t icm42670_port_write(icm42670_port_dev_t dev, const uint8_t *data, size_t len)
+{
+    return i2c_master_transmit(dev, data, len, -1);
+}
+
+esp_err_t icm42670_port_write_read(icm42670_port_dev_t dev, const uint8_t *write_data, size_t write_len,
+                                   uint8_t *read_data, size_t read_len)
+{
+    return i2c_master_transmit_receive(dev, write_data, write_len, read_data, read_len, -1);
+}
+
+void icm42670_port_delay_us(uint32_t us)
+{
+    esp_rom_delay_us(us);
+}
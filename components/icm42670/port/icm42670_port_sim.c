@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "icm42670_port.h"
+#include "icm42670_sim.h"
+
+/* Bank 0 registers the simulation gives behaviour to */
+#define SIM_MCLK_RDY            0x00
+#define SIM_SIGNAL_PATH_RESET   0x02
+#define SIM_TEMP_DATA           0x09
+#define SIM_ACCEL_DATA          0x0B
+#define SIM_GYRO_DATA           0x11
+#define SIM_PWR_MGMT0           0x1F
+#define SIM_GYRO_CONFIG0        0x20
+#define SIM_ACCEL_CONFIG0       0x21
+#define SIM_APEX_CONFIG0        0x25
+#define SIM_APEX_CONFIG1        0x26
+#define SIM_FIFO_CONFIG1        0x28
+#define SIM_INTF_CONFIG0        0x35
+#define SIM_FIFO_COUNTH         0x3D
+#define SIM_FIFO_COUNTL         0x3E
+#define SIM_FIFO_DATA           0x3F
+#define SIM_WHOAMI              0x75
+#define SIM_BLK_SEL_W           0x79
+#define SIM_MADDR_W             0x7A
+#define SIM_M_W                 0x7B
+#define SIM_MREG1_FIFO_CONFIG5  0x01
+
+#define SIM_ID                  0x67
+#define SIM_BANK_MREG1          0x00
+#define SIM_MCLK_RDY_BIT        (1 << 3)
+#define SIM_MCLK_ON_BITS        0x1F    /* PWR_MGMT0: IDLE, or either sensor in any mode */
+#define SIM_FIFO_FLUSH_BIT      (1 << 2)
+#define SIM_APEX_SELF_CLEAR     0x05    /* DMP_MEM_RESET_EN, DMP_INIT_EN */
+#define SIM_COUNT_RECORDS_BIT   (1 << 6)
+#define SIM_FIFO_ACCEL_EN_BIT   (1 << 0)
+#define SIM_FIFO_GYRO_EN_BIT    (1 << 1)
+#define SIM_FIFO_EMPTY_BYTE     0xFF
+#define SIM_ACCEL_MODE_MASK     0x03    /* 0x2 low power, 0x3 low noise; else off */
+#define SIM_GYRO_MODE_MASK      0x0C    /* 0xC low noise; else off or standby */
+#define SIM_AXES_BYTES          6
+#define SIM_SENSOR_OFF_HI       0x80    /* -32768, big-endian */
+
+struct icm42670_sim_t {
+    uint8_t regs[256];
+    uint8_t mreg1[256];
+    uint8_t fifo[ICM42670_FIFO_SIZE];
+    size_t fifo_len;
+    size_t fifo_pos;
+    uint32_t nacks_pending;
+    icm42670_sim_stats_t stats;
+};
+
+static bool sim_nack_injected(struct icm42670_sim_t *sim)
+{
+    if (sim->nacks_pending == 0) {
+        return false;
+    }
+    sim->nacks_pending--;
+    return true;
+}
+
+static bool sim_mclk_running(const struct icm42670_sim_t *sim)
+{
+    return sim->regs[SIM_PWR_MGMT0] & SIM_MCLK_ON_BITS;
+}
+
+static uint16_t sim_fifo_count(const struct icm42670_sim_t *sim)
+{
+    size_t bytes = sim->fifo_len - sim->fifo_pos;
+    uint8_t config5 = sim->mreg1[SIM_MREG1_FIFO_CONFIG5];
+    bool both = (config5 & SIM_FIFO_ACCEL_EN_BIT) && (config5 & SIM_FIFO_GYRO_EN_BIT);
+    size_t packet_size = (both || !(config5 & (SIM_FIFO_ACCEL_EN_BIT | SIM_FIFO_GYRO_EN_BIT))) ? 16 : 8;
+
+    return (sim->regs[SIM_INTF_CONFIG0] & SIM_COUNT_RECORDS_BIT) ? bytes / packet_size : bytes;
+}
+
+/* Data registers of a sensor that is off read -32768 */
+static bool sim_data_off(const struct icm42670_sim_t *sim, uint8_t reg)
+{
+    uint8_t pwr = sim->regs[SIM_PWR_MGMT0];
+
+    if (reg >= SIM_ACCEL_DATA && reg < SIM_ACCEL_DATA + SIM_AXES_BYTES) {
+        return (pwr & SIM_ACCEL_MODE_MASK) < 0x02;
+    }
+    if (reg >= SIM_GYRO_DATA && reg < SIM_GYRO_DATA + SIM_AXES_BYTES) {
+        return (pwr & SIM_GYRO_MODE_MASK) != SIM_GYRO_MODE_MASK;
+    }
+    return false;
+}
+
+static uint8_t sim_read_reg(struct icm42670_sim_t *sim, uint8_t reg)
+{
+    if (sim_data_off(sim, reg)) {
+        return (reg % 2) ? SIM_SENSOR_OFF_HI : 0x00;
+    }
+
+    switch (reg) {
+    case SIM_MCLK_RDY:
+        return sim_mclk_running(sim) ? SIM_MCLK_RDY_BIT : 0;
+    case SIM_FIFO_COUNTH:
+        return sim_fifo_count(sim) >> 8;
+    case SIM_FIFO_COUNTL:
+        return sim_fifo_count(sim) & 0xFF;
+    case SIM_FIFO_DATA:
+        return (sim->fifo_pos < sim->fifo_len) ? sim->fifo[sim->fifo_pos++] : SIM_FIFO_EMPTY_BYTE;
+    default:
+        return sim->regs[reg];
+    }
+}
+
+static void sim_write_reg(struct icm42670_sim_t *sim, uint8_t reg, uint8_t value)
+{
+    switch (reg) {
+    case SIM_SIGNAL_PATH_RESET:
+        if (value & SIM_FIFO_FLUSH_BIT) {
+            sim->fifo_len = 0;
+            sim->fifo_pos = 0;
+        }
+        value = 0;
+        break;
+    case SIM_APEX_CONFIG0:
+        value &= ~SIM_APEX_SELF_CLEAR;
+        break;
+    case SIM_M_W:
+        /* Without MCLK the write never reaches the MREG */
+        if (sim->regs[SIM_BLK_SEL_W] == SIM_BANK_MREG1 && sim_mclk_running(sim)) {
+            sim->mreg1[sim->regs[SIM_MADDR_W]] = value;
+        }
+        break;
+    default:
+        break;
+    }
+    sim->regs[reg] = value;
+}
+
+esp_err_t icm42670_sim_create(icm42670_sim_handle_t *sim_ret)
+{
+    struct icm42670_sim_t *sim = calloc(1, sizeof(struct icm42670_sim_t));
+    if (sim == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    /* Reset values from the datasheet */
+    sim->regs[SIM_GYRO_CONFIG0] = 0x06;
+    sim->regs[SIM_ACCEL_CONFIG0] = 0x06;
+    sim->regs[SIM_APEX_CONFIG0] = 0x08;
+    sim->regs[SIM_APEX_CONFIG1] = 0xA2;
+    sim->regs[SIM_FIFO_CONFIG1] = 0x01;
+    sim->regs[SIM_INTF_CONFIG0] = 0x30;
+    sim->regs[SIM_WHOAMI] = SIM_ID;
+    *sim_ret = sim;
+    return ESP_OK;
+}
+
+void icm42670_sim_delete(icm42670_sim_handle_t sim)
+{
+    free(sim);
+}
+
+uint8_t icm42670_sim_get_reg(icm42670_sim_handle_t sim, uint8_t reg)
+{
+    return sim->regs[reg];
+}
+
+void icm42670_sim_set_reg(icm42670_sim_handle_t sim, uint8_t reg, uint8_t value)
+{
+    sim->regs[reg] = value;
+}
+
+static void sim_put_be16(uint8_t *out, int16_t value)
+{
+    out[0] = (uint16_t) value >> 8;
+    out[1] = (uint16_t) value & 0xFF;
+}
+
+void icm42670_sim_set_data(icm42670_sim_handle_t sim, const icm42670_all_raw_value_t *raw)
+{
+    const int16_t values[7] = {raw->temp, raw->acce.x, raw->acce.y, raw->acce.z, raw->gyro.x, raw->gyro.y, raw->gyro.z};
+
+    for (int i = 0; i < 7; i++) {
+        sim_put_be16(&sim->regs[SIM_TEMP_DATA + 2 * i], values[i]);
+    }
+}
+
+uint8_t icm42670_sim_get_mreg1(icm42670_sim_handle_t sim, uint8_t reg)
+{
+    return sim->mreg1[reg];
+}
+
+esp_err_t icm42670_sim_fifo_push(icm42670_sim_handle_t sim, const uint8_t *data, size_t len)
+{
+    if (sim->fifo_len + len > sizeof(sim->fifo)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(&sim->fifo[sim->fifo_len], data, len);
+    sim->fifo_len += len;
+    return ESP_OK;
+}
+
+void icm42670_sim_inject_nack(icm42670_sim_handle_t sim, uint32_t count)
+{
+    sim->nacks_pending = count;
+}
+
+void icm42670_sim_get_stats(icm42670_sim_handle_t sim, icm42670_sim_stats_t *stats)
+{
+    *stats = sim->stats;
+}
+
+void icm42670_sim_reset_stats(icm42670_sim_handle_t sim)
+{
+    memset(&sim->stats, 0, sizeof(sim->stats));
+}
+
+esp_err_t icm42670_port_add_device(icm42670_bus_handle_t bus, uint8_t dev_addr, icm42670_port_dev_t *dev_ret)
+{
+    if (dev_addr != ICM42670_I2C_ADDRESS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *dev_ret = bus;
+    return ESP_OK;
+}
+
+void icm42670_port_rm_device(icm42670_port_dev_t dev)
+{
+    (void) dev;
+}
+
+/* Register address, then data to it and the registers after */
+esp_err_t icm42670_port_write(icm42670_port_dev_t dev, const uint8_t *data, size_t len)
+{
+    struct icm42670_sim_t *sim = dev;
+
+    sim->stats.transactions++;
+    if (sim_nack_injected(sim) || len == 0) {
+        sim->stats.nacks++;
+        return ESP_FAIL;
+    }
+    sim->stats.bytes_written += len;
+
+    for (size_t i = 1; i < len; i++) {
+        sim_write_reg(sim, (uint8_t)(data[0] + i - 1), data[i]);
+    }
+    return ESP_OK;
+}
+
+/* Register address, then a burst read; FIFO_DATA is read without moving on */
+esp_err_t icm42670_port_write_read(icm42670_port_dev_t dev, const uint8_t *write_data, size_t write_len,
+                                   uint8_t *read_data, size_t read_len)
+{
+    struct icm42670_sim_t *sim = dev;
+
+    sim->stats.transactions++;
+    if (sim_nack_injected(sim) || write_len != 1) {
+        sim->stats.nacks++;
+        return ESP_FAIL;
+    }
+    sim->stats.bytes_written += write_len;
+    sim->stats.bytes_read += read_len;
+
+    uint8_t reg = write_data[0];
+    for (size_t i = 0; i < read_len; i++) {
+        read_data[i] = sim_read_reg(sim, reg);
+        if (reg != SIM_FIFO_DATA) {
+            reg++;
+        }
+    }
+    return ESP_OK;
+}
+
+void icm42670_port_delay_us(uint32_t us)
+{
+    usleep(us);
+}
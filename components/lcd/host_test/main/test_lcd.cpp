@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lcd.h"
+
+static lcd_sim_handle_t s_sim;
+static lcd* s_lcd;
+
+static void display_open(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, lcd_sim_create(&s_sim));
+    s_lcd = new lcd(s_sim);
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->init());
+    lcd_sim_reset_stats(s_sim);
+}
+
+static void display_close(void)
+{
+    delete s_lcd;
+    lcd_sim_delete(s_sim);
+}
+
+static void assert_row(uint8_t row, const char* expected)
+{
+    char shown[LCD_COLS + 1];
+
+    lcd_sim_get_row(s_sim, row, shown);
+    TEST_ASSERT_EQUAL_STRING(expected, shown);
+}
+
+/* Bus traffic since the last call */
+static lcd_sim_stats_t take_stats(void)
+{
+    lcd_sim_stats_t stats;
+
+    lcd_sim_get_stats(s_sim, &stats);
+    lcd_sim_reset_stats(s_sim);
+    return stats;
+}
+
+TEST_CASE("init leaves a blank display and a full white backlight", "[lcd]")
+{
+    lcd_sim_backlight_t backlight;
+
+    display_open();
+    TEST_ASSERT_TRUE(lcd_sim_display_on(s_sim));
+    assert_row(0, "                ");
+    assert_row(1, "                ");
+
+    lcd_sim_get_backlight(s_sim, &backlight);
+    TEST_ASSERT_EQUAL(255, backlight.r);
+    TEST_ASSERT_EQUAL(255, backlight.g);
+    TEST_ASSERT_EQUAL(255, backlight.b);
+    TEST_ASSERT_FALSE(backlight.groupEnabled);
+    TEST_ASSERT_FALSE(backlight.blinking);
+    TEST_ASSERT_FALSE(backlight.asleep);
+    display_close();
+}
+
+TEST_CASE("printf draws at the cursor and a flush with no change sends nothing", "[lcd]")
+{
+    display_open();
+    s_lcd->setCursor(0, 0);
+    s_lcd->printf("T=%d%%", 42);
+    s_lcd->setCursor(3, 1);
+    s_lcd->printf("%-4s|%04x", "ab", 0xbeef);
+    TEST_ASSERT_EQUAL(0, take_stats().transactions);   // Drawing alone stays off the bus
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(0, "T=42%           ");
+    assert_row(1, "   ab  |beef    ");
+    TEST_ASSERT_EQUAL(2, take_stats().transactions);    // One run per row
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    TEST_ASSERT_EQUAL(0, take_stats().transactions);
+    display_close();
+}
+
+TEST_CASE("one changed digit costs one transaction of four bytes", "[lcd]")
+{
+    display_open();
+    s_lcd->field(6, 0, 5, 2345, 2);
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(0, "      23.45     ");
+    take_stats();
+
+    s_lcd->field(6, 0, 5, 2346, 2);
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(0, "      23.46     ");
+    lcd_sim_stats_t stats = take_stats();
+    TEST_ASSERT_EQUAL(1, stats.transactions);
+    TEST_ASSERT_EQUAL(4, stats.bytesWritten);   // Address command, data control byte, the digit
+    display_close();
+}
+
+TEST_CASE("fields pad, and fill with # when the value doesn't fit", "[lcd]")
+{
+    display_open();
+    s_lcd->field(0, 0, 4, -7);
+    s_lcd->field(5, 0, 3, 1234);
+    s_lcd->field(9, 0, 5, "ab");
+    s_lcd->field(14, 1, 4, 123);    // Only two cells left on the row
+    s_lcd->field(0, 1, 4, 99);
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(0, "  -7 ### ab     ");
+    assert_row(1, "  99          ##");
+    display_close();
+}
+
+TEST_CASE("a glyph is uploaded once and shown from its CGRAM slot", "[lcd]")
+{
+    static const uint8_t degree[LCD_GLYPH_ROWS] = {0x06, 0x09, 0x09, 0x06, 0x00, 0x00, 0x00, 0x00};
+    uint8_t bitmap[LCD_GLYPH_ROWS];
+    char shown[LCD_COLS + 1];
+
+    display_open();
+    s_lcd->setCursor(0, 0);
+    s_lcd->draw("25");
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->drawGlyph(LCD_GLYPH_DEGREE));
+    s_lcd->draw("C");
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+
+    lcd_sim_get_row(s_sim, 0, shown);
+    TEST_ASSERT_EQUAL('2', shown[0]);
+    TEST_ASSERT_TRUE(shown[2] >= 0 && shown[2] < 0x10);     // A CGRAM code, not ROM
+    TEST_ASSERT_EQUAL('C', shown[3]);
+    lcd_sim_get_glyph(s_sim, shown[2] % LCD_CGRAM_SLOTS, bitmap);
+    TEST_ASSERT_EQUAL_MEMORY(degree, bitmap, sizeof(bitmap));
+
+    // Resident already: drawing it again changes no cell and uploads nothing
+    take_stats();
+    s_lcd->setCursor(2, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->drawGlyph(LCD_GLYPH_DEGREE));
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    TEST_ASSERT_EQUAL(0, take_stats().transactions);
+    display_close();
+}
+
+TEST_CASE("marquee shifts one command per step and stop restores the framebuffer", "[lcd]")
+{
+    static const char text[] = "0123456789ABCDEFGHIJ";
+    char expected[LCD_COLS + 1];
+
+    display_open();
+    s_lcd->setCursor(0, 1);
+    s_lcd->draw("static");
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->setMarqueeText(0, text));
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->marqueeStart(20));
+    take_stats();
+    vTaskDelay(pdMS_TO_TICKS(110));
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->marqueeStop());
+
+    int shift = lcd_sim_get_shift(s_sim);
+    lcd_sim_stats_t stats = take_stats();
+    TEST_ASSERT_EQUAL(0, shift);                        // Return home undid it
+    TEST_ASSERT_GREATER_THAN(2, stats.transactions);    // Steps, plus return home
+    TEST_ASSERT_EQUAL(2 * stats.transactions, stats.bytesWritten);
+
+    // Framebuffer text was held back while the marquee ran, and comes back in full
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(1, "static          ");
+    memset(expected, ' ', LCD_COLS);
+    expected[LCD_COLS] = '\0';
+    assert_row(0, expected);
+    display_close();
+}
+
+TEST_CASE("marquee shows the text window the display has shifted to", "[lcd]")
+{
+    static const char text[] = "0123456789ABCDEFGHIJ";
+    char padded[LCD_DDRAM_COLS + 1];
+    char expected[LCD_COLS + 1];
+
+    display_open();
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->setMarqueeText(0, text));
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->marqueeStart(20));
+    vTaskDelay(pdMS_TO_TICKS(70));
+
+    // Read shift and row together while no step lands in between
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->marqueeStart(1000));
+    int shift = lcd_sim_get_shift(s_sim);
+    TEST_ASSERT_GREATER_THAN(0, shift);
+
+    memset(padded, ' ', LCD_DDRAM_COLS);
+    memcpy(padded, text, strlen(text));
+    for (int i = 0; i < LCD_COLS; i++) {
+        expected[i] = padded[(shift + i) % LCD_DDRAM_COLS];
+    }
+    expected[LCD_COLS] = '\0';
+    assert_row(0, expected);
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->marqueeStop());
+    display_close();
+}
+
+TEST_CASE("a single RGB channel change is a single register write", "[lcd]")
+{
+    lcd_sim_backlight_t backlight;
+
+    display_open();
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->setRGB(255, 0, 255));
+    lcd_sim_stats_t stats = take_stats();
+    TEST_ASSERT_EQUAL(1, stats.transactions);
+    TEST_ASSERT_EQUAL(2, stats.bytesWritten);
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->setRGB(255, 0, 255));
+    TEST_ASSERT_EQUAL(0, take_stats().transactions);
+
+    lcd_sim_get_backlight(s_sim, &backlight);
+    TEST_ASSERT_EQUAL(255, backlight.r);
+    TEST_ASSERT_EQUAL(0, backlight.g);
+    TEST_ASSERT_EQUAL(255, backlight.b);
+    display_close();
+}
+
+TEST_CASE("stopping the blink goes back to the dimmed brightness", "[lcd]")
+{
+    lcd_sim_backlight_t backlight;
+
+    display_open();
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->setBrightness(64));
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->blinkBacklight(1000, 50));
+    lcd_sim_get_backlight(s_sim, &backlight);
+    TEST_ASSERT_TRUE(backlight.blinking);
+    TEST_ASSERT_TRUE(backlight.groupEnabled);
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->blinkBacklight(0, 0));
+    lcd_sim_get_backlight(s_sim, &backlight);
+    TEST_ASSERT_FALSE(backlight.blinking);
+    TEST_ASSERT_TRUE(backlight.groupEnabled);
+    TEST_ASSERT_EQUAL(64, backlight.groupPwm);
+    display_close();
+}
+
+TEST_CASE("cells a NACKed flush didn't send go out with the next one", "[lcd]")
+{
+    display_open();
+    s_lcd->field(0, 0, 3, 123);
+    lcd_sim_inject_nack(s_sim, 1);
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(0, "                ");
+
+    TEST_ASSERT_EQUAL(ESP_OK, s_lcd->flush());
+    assert_row(0, "123             ");
+    display_close();
+}
+
+extern "C" void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,9 @@
+import pytest
+from pytest_embedded import Dut
+from pytest_embedded_idf.utils import idf_parametrize
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_lcd_host(dut: Dut) -> None:
+    dut.expect_exact('Tests 0 Failures 0 Ignored', timeout=60)
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdarg.h>
+#include <stdint.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#include "lcd_sim.h"
+typedef lcd_sim_handle_t lcd_bus_handle_t;          // Simulated bus on the host build
+#else
+#include "driver/i2c_master.h"
+typedef i2c_master_bus_handle_t lcd_bus_handle_t;   // I2C bus, from i2c_new_master_bus()
+#endif
+typedef void* lcd_port_dev_t;
+
+#define LCD_ADDRESS         0x3E
+#define RGB_ADDRESS         0x2D
+
+// Each controller gets its own SCL rate on the shared bus
+#define LCD_SCL_SPEED_HZ    100000
+#define RGB_SCL_SPEED_HZ    400000
+#define LCD_I2C_TIMEOUT_MS  100
+
+#define LCD_COLS            16
+#define LCD_ROWS            2
+#define LCD_DDRAM_COLS      40      // Per row; the display shows a 16-column window
+
+#define LCD_CTRL_CMD        0x80    // Co=1, RS=0: one command byte follows
+#define LCD_CTRL_DATA       0x40    // Co=0, RS=1: every remaining byte is data
+
+// Backlight controller registers (PCA9633 layout)
+#define RGB_REG_MODE1       0x00
+#define RGB_REG_MODE2       0x01
+#define RGB_REG_BLUE        0x02
+#define RGB_REG_GREEN       0x03
+#define RGB_REG_RED         0x04
+#define RGB_REG_GRPPWM      0x06    // Group duty cycle (blink) or brightness (dim)
+#define RGB_REG_GRPFREQ     0x07    // Blink period = (GRPFREQ + 1) / 24 s
+#define RGB_REG_LEDOUT      0x08
+#define RGB_REG_COUNT       9
+
+#define RGB_MODE2_DMBLNK    0x20    // Group control blinks instead of dimming
+#define RGB_LEDOUT_PWM      0xAA    // Channels follow their own PWM register only
+#define RGB_LEDOUT_GROUP    0xFF    // Channels also gated by the group PWM
+
+// Clean cells between two dirty runs that are rewritten rather than split
+// into a second transaction; a new transaction costs more than a few bytes
+#define LCD_RUN_MERGE_GAP   4
+
+// Custom glyphs live in the 8 CGRAM slots. The framebuffer holds them as
+// 0x08-0x0F, which the controller maps onto the same slots, so a glyph never
+// looks like a string terminator.
+#define LCD_CGRAM_SLOTS     8
+#define LCD_GLYPH_ROWS      8
+#define LCD_GLYPH_CHAR(slot)    (char)(0x08 + (slot))
+#define LCD_CHAR_FULL_BLOCK     (char)0xFF  // In character ROM, costs no slot
+
+// Built-in glyphs; application glyphs pass their own bitmap with an ID from
+// LCD_GLYPH_USER up
+enum : uint16_t {
+    LCD_GLYPH_DEGREE = 0,
+    LCD_GLYPH_BAR1,                 // Leftmost 1..4 pixel columns lit, for bar graphs
+    LCD_GLYPH_BAR2,
+    LCD_GLYPH_BAR3,
+    LCD_GLYPH_BAR4,
+    LCD_GLYPH_ARROW_UP,
+    LCD_GLYPH_ARROW_DOWN,
+    LCD_GLYPH_BUILTIN_COUNT,
+    LCD_GLYPH_USER = 0x100,
+};
+
+// Text goes into a shadow framebuffer; flush() sends only the cells that
+// differ from what the display already shows.
+class lcd {
+public:
+    lcd(lcd_bus_handle_t bus);
+    ~lcd();
+    esp_err_t init();               // Adds both controllers to the bus, then sets them up
+    esp_err_t clear();
+    void setCursor(unsigned char col, unsigned char row);
+    void draw(const char* str);     // Writes at the cursor, clipped to the row; no I2C
+    void printstr(const char* str); // draw() then flush()
+    // Integer-only printf at the cursor, no I2C: %d %i %u %x %X %c %s %% with
+    // '-' and '0' flags, a width and an optional l; anything else prints '?'
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    void vprintf(const char* fmt, va_list ap);
+    // Fills exactly cells col..col+width-1, so only that field changes.
+    // value is fixed-point with the given decimals (2345, 2 -> "23.45");
+    // '#' across the field if it doesn't fit, counting only the cells left on the row.
+    void field(uint8_t col, uint8_t row, uint8_t width, int32_t value, uint8_t decimals = 0);
+    void field(uint8_t col, uint8_t row, uint8_t width, const char* str);  // Left-aligned, blank-padded
+    // Formatter behind printf(), writes at most size - 1 chars plus NUL; returns the length written
+    static size_t format(char* out, size_t size, const char* fmt, va_list ap);
+
+    // Marquee: each row's text (up to 40 chars, blank-padded) is loaded into
+    // DDRAM once, then a timer shifts the window one column left per step,
+    // one command byte each. The shift moves both rows, and the 40 columns
+    // wrap, so the text loops. Framebuffer text is held back until marqueeStop().
+    esp_err_t setMarqueeText(uint8_t row, const char* text);  // Reloads the row if running
+    esp_err_t marqueeStart(uint16_t stepMs);
+    esp_err_t marqueeStop();
+    // Slot character for a glyph, assigning a CGRAM slot (LRU) if it isn't
+    // resident; -1 if every slot is on screen. bitmap may be null for built-ins.
+    int glyph(uint16_t id, const uint8_t* bitmap = nullptr);
+    esp_err_t drawGlyph(uint16_t id, const uint8_t* bitmap = nullptr);  // At the cursor; no I2C
+    void drawBar(uint8_t width, uint8_t value, uint8_t max);  // 5 steps per cell, at the cursor
+    esp_err_t flush();
+    esp_err_t setRGB(uint8_t r, uint8_t g, uint8_t b);   // Writes only the channels that changed
+    esp_err_t setBrightness(uint8_t level);               // Scales all channels in hardware
+    esp_err_t blinkBacklight(uint16_t periodMs, uint8_t dutyPercent);  // periodMs 0 stops blinking
+
+private:
+    esp_err_t sendCommand(uint8_t cmd);
+    esp_err_t sendRun(uint8_t row, uint8_t col, uint8_t len);
+    esp_err_t sendGlyph(uint8_t slot);
+    void putFieldText(uint8_t col, uint8_t row, uint8_t width, const char* text, size_t len, bool right);
+    uint8_t slotsOnScreen();
+    esp_err_t sendMarqueeRow(uint8_t row);
+    static void marqueeStep(void* arg);
+    esp_err_t setReg(uint8_t reg, uint8_t data);  // Skipped if the shadow already holds data
+    esp_err_t addDevice(uint8_t addr, uint32_t sclHz, lcd_port_dev_t* dev);
+    esp_err_t i2cWrite(lcd_port_dev_t dev, const uint8_t* data, size_t len);
+
+    lcd_bus_handle_t bus;            // Shared with the other sensors; the driver serialises access
+    lcd_port_dev_t lcdDev;
+    lcd_port_dev_t rgbDev;
+    char fb[LCD_ROWS][LCD_COLS];     // What the display should show
+    char shown[LCD_ROWS][LCD_COLS];  // What the display shows
+    uint8_t curCol, curRow;          // Framebuffer write position
+    int8_t hwCol, hwRow;             // Display address counter, -1 if unknown
+    uint8_t rgbShadow[RGB_REG_COUNT];  // Last value written to each backlight register
+    uint16_t rgbKnown;                 // Bit per register, set once rgbShadow is valid
+    uint8_t brightness;                // Last setBrightness() level; GRPPWM holds the duty while blinking
+
+    struct glyphSlot {
+        uint16_t id;
+        bool used;
+        bool dirty;                  // Assigned but not uploaded yet; flush() sends it
+        uint32_t lastUse;
+        uint8_t bitmap[LCD_GLYPH_ROWS];
+    };
+    glyphSlot slots[LCD_CGRAM_SLOTS];
+    uint32_t glyphClock;             // Bumped on every glyph() lookup, for LRU
+
+    char marqueeText[LCD_ROWS][LCD_DDRAM_COLS];
+    esp_timer_handle_t marqueeTimer;
+    SemaphoreHandle_t marqueeLock;   // Keeps a late shift from landing after marqueeStop()
+    bool marqueeOn;
+};
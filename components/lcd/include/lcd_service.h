@@ -0,0 +1,79 @@
+#pragma once
+
+#include "lcd.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define LCD_SERVICE_QUEUE_LEN   8
+
+struct lcd_service_stats_t {
+    uint32_t posted;            // Commands accepted into the queue
+    uint32_t dropped;           // Commands rejected because the queue stayed full
+    uint32_t flushes;           // Framebuffer flushes, one per drained batch
+    uint32_t errors;            // Failed bus writes
+    esp_err_t lastError;        // Result of the most recent bus write
+    UBaseType_t queueDepth;     // Commands waiting right now
+    UBaseType_t maxQueueDepth;  // Deepest the queue has been
+    uint32_t lastLatencyUs;     // Oldest command in the last batch, post to flush done
+    uint32_t maxLatencyUs;
+};
+
+// Background writer: callers post render commands and return immediately;
+// a task drains the queue into the framebuffer and flushes once per batch.
+// Once started, the service owns the lcd; don't call it directly.
+class lcd_service {
+public:
+    lcd_service(lcd& display, size_t queueLen = LCD_SERVICE_QUEUE_LEN);
+    ~lcd_service();
+    esp_err_t start(UBaseType_t priority = 3, uint32_t stackSize = 3072);
+    void stop();
+
+    // Return false if the queue was still full after waiting
+    bool print(uint8_t col, uint8_t row, const char* str, TickType_t wait = 0);
+    // Formatted by lcd::format() in the caller, so the arguments needn't outlive the call
+    bool printf(uint8_t col, uint8_t row, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+    bool field(uint8_t col, uint8_t row, uint8_t width, int32_t value, uint8_t decimals = 0, TickType_t wait = 0);
+    bool drawGlyph(uint8_t col, uint8_t row, uint16_t id, const uint8_t* bitmap = nullptr, TickType_t wait = 0);
+    bool drawBar(uint8_t col, uint8_t row, uint8_t width, uint8_t value, uint8_t max, TickType_t wait = 0);
+    bool setMarqueeText(uint8_t row, const char* text, TickType_t wait = 0);
+    bool marqueeStart(uint16_t stepMs, TickType_t wait = 0);
+    bool marqueeStop(TickType_t wait = 0);
+    bool clear(TickType_t wait = 0);
+    bool setRGB(uint8_t r, uint8_t g, uint8_t b, TickType_t wait = 0);
+    bool setBrightness(uint8_t level, TickType_t wait = 0);
+    bool blinkBacklight(uint16_t periodMs, uint8_t dutyPercent, TickType_t wait = 0);
+
+    void getStats(lcd_service_stats_t* stats);
+
+private:
+    enum class op : uint8_t { print, field, glyph, bar, marqueeText, marqueeStart, marqueeStop, clear, rgb, brightness, blink, stop };
+
+    struct msg {
+        op type;
+        uint8_t col, row;
+        uint8_t r, g, b;        // Colour; r doubles as brightness level or blink duty,
+                                // r/g/b as bar width/value/max, r/g as field width/decimals
+        uint16_t periodMs;
+        int32_t value;
+        uint16_t glyphId;
+        bool hasBitmap;
+        int64_t postedUs;
+        char text[LCD_DDRAM_COLS + 1];  // Row text, marquee text or the glyph bitmap
+    };
+
+    static void taskEntry(void* arg);
+    void run();
+    bool post(msg& m, TickType_t wait);
+    esp_err_t apply(const msg& m);
+    void record(esp_err_t ret);
+
+    lcd& display;
+    size_t queueLen;
+    QueueHandle_t queue;
+    TaskHandle_t task;
+    SemaphoreHandle_t doneSem;
+    portMUX_TYPE lock;
+    lcd_service_stats_t stats;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Simulated LCD1602 text controller and PCA9633-style backlight controller on
+// a simulated I2C bus, used by the linux target build. Every write is decoded
+// the way the hardware would: the control-byte stream into DDRAM/CGRAM and
+// display shift, register writes into backlight state. Bus traffic is counted
+// so a caller can bracket one lcd call with lcd_sim_reset_stats() and
+// lcd_sim_get_stats() and check what it cost.
+
+#define LCD_SIM_DDRAM_COLS  40
+
+struct lcd_sim_stats_t {
+    uint32_t transactions;  // Transfers addressed to either controller, NACKed ones included
+    uint32_t bytesWritten;  // Payload bytes, address byte excluded
+    uint32_t nacks;         // Transfers nobody acknowledged
+    uint64_t busTimeUs;     // Modelled bus time at each device's SCL rate
+};
+
+struct lcd_sim_backlight_t {
+    uint8_t r, g, b;        // Channel PWM registers
+    bool groupEnabled;      // LEDOUT routes the channels through the group PWM
+    bool blinking;          // Group control blinks rather than dims
+    uint8_t groupPwm;       // Brightness, or blink duty out of 256
+    uint16_t blinkPeriodMs;
+    bool asleep;            // MODE1 SLEEP: oscillator off, channels dark
+};
+
+typedef struct lcd_sim_t* lcd_sim_handle_t;
+
+// Create a simulated bus with both controllers attached, display blank
+esp_err_t lcd_sim_create(lcd_sim_handle_t* simRet);
+void lcd_sim_delete(lcd_sim_handle_t sim);
+
+// The 16 visible characters of a row, after display shift, NUL-terminated.
+// Codes below 0x10 are CGRAM glyphs; see lcd_sim_get_glyph().
+void lcd_sim_get_row(lcd_sim_handle_t sim, uint8_t row, char out[17]);
+void lcd_sim_get_glyph(lcd_sim_handle_t sim, uint8_t slot, uint8_t bitmap[8]);
+bool lcd_sim_display_on(lcd_sim_handle_t sim);
+int lcd_sim_get_shift(lcd_sim_handle_t sim);  // Columns shifted left, 0..39
+void lcd_sim_get_backlight(lcd_sim_handle_t sim, lcd_sim_backlight_t* out);
+
+// Make the next count transfers fail with a NACK
+void lcd_sim_inject_nack(lcd_sim_handle_t sim, uint32_t count);
+void lcd_sim_get_stats(lcd_sim_handle_t sim, lcd_sim_stats_t* stats);
+void lcd_sim_reset_stats(lcd_sim_handle_t sim);
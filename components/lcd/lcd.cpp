@@ -0,0 +1,592 @@
+#include "lcd.h"
+#include "lcd_port.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+static const uint8_t builtinGlyphs[LCD_GLYPH_BUILTIN_COUNT][LCD_GLYPH_ROWS] = {
+    {0x06, 0x09, 0x09, 0x06, 0x00, 0x00, 0x00, 0x00},  // Degree
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},  // Bar, 1 column
+    {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18},
+    {0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C},
+    {0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E},
+    {0x04, 0x0E, 0x15, 0x04, 0x04, 0x04, 0x04, 0x00},  // Arrow up
+    {0x04, 0x04, 0x04, 0x04, 0x15, 0x0E, 0x04, 0x00},  // Arrow down
+};
+
+lcd::lcd(lcd_bus_handle_t bus) : bus(bus), lcdDev(nullptr), rgbDev(nullptr), curCol(0), curRow(0), hwCol(-1), hwRow(-1), rgbKnown(0), brightness(0xFF), glyphClock(0), marqueeTimer(nullptr), marqueeLock(nullptr), marqueeOn(false) {
+    memset(slots, 0, sizeof(slots));
+    memset(marqueeText, ' ', sizeof(marqueeText));
+    memset(fb, ' ', sizeof(fb));
+    memset(shown, ' ', sizeof(shown));
+}
+
+lcd::~lcd() {
+    if (marqueeTimer) {
+        esp_timer_stop(marqueeTimer);
+        esp_timer_delete(marqueeTimer);
+    }
+    if (marqueeLock) vSemaphoreDelete(marqueeLock);
+    if (lcdDev) lcd_port_rm_device(lcdDev);
+    if (rgbDev) lcd_port_rm_device(rgbDev);
+}
+
+esp_err_t lcd::i2cWrite(lcd_port_dev_t dev, const uint8_t* data, size_t len) {
+    return lcd_port_write(dev, data, len);
+}
+
+esp_err_t lcd::addDevice(uint8_t addr, uint32_t sclHz, lcd_port_dev_t* dev) {
+    if (*dev) {
+        return ESP_OK;  // init() called again, e.g. after a display reset
+    }
+    return lcd_port_add_device(bus, addr, sclHz, dev);
+}
+
+esp_err_t lcd::init() {
+    esp_err_t ret = addDevice(LCD_ADDRESS, LCD_SCL_SPEED_HZ, &lcdDev);
+    if (ret == ESP_OK) ret = addDevice(RGB_ADDRESS, RGB_SCL_SPEED_HZ, &rgbDev);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    sendCommand(0x38);  // Function set
+    sendCommand(0x39);  // Function set
+    sendCommand(0x14);  // Internal OSC frequency
+    sendCommand(0x70);  // Contrast set
+    sendCommand(0x56);  // Power/icon/contrast
+    sendCommand(0x6C);  // Follower control
+
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    sendCommand(0x38);  // Function set
+    sendCommand(0x0C);  // Display ON
+    sendCommand(0x06);  // Entry mode: increment, no shift
+    ret = clear();
+
+    // CGRAM is undefined after power-up; glyphs in use get uploaded again
+    for (glyphSlot& s : slots) {
+        s.dirty = s.used;
+    }
+
+    rgbKnown = 0;  // The controller may hold anything after a reset of ours
+    if (ret == ESP_OK) ret = setReg(RGB_REG_MODE1, 0x00);  // Normal mode, oscillator on
+    if (ret == ESP_OK) ret = setReg(RGB_REG_MODE2, 0x00);  // Group dimming
+    if (ret == ESP_OK) ret = setReg(RGB_REG_LEDOUT, RGB_LEDOUT_PWM);
+    if (ret == ESP_OK) ret = setRGB(255, 255, 255);
+    brightness = 0xFF;
+    return ret;
+}
+
+esp_err_t lcd::clear() {
+    if (marqueeOn) {
+        marqueeStop();
+    }
+    esp_err_t ret = sendCommand(0x01);  // Clear display, address counter to 0
+    vTaskDelay(pdMS_TO_TICKS(2));
+
+    memset(fb, ' ', sizeof(fb));
+    curCol = curRow = 0;
+    if (ret != ESP_OK) {
+        // Display contents unknown: make every cell dirty for the next flush
+        memset(shown, 0, sizeof(shown));
+        hwCol = hwRow = -1;
+        return ret;
+    }
+    memset(shown, ' ', sizeof(shown));
+    hwCol = hwRow = 0;
+    return ESP_OK;
+}
+
+esp_err_t lcd::sendCommand(uint8_t cmd) {
+    uint8_t data[2] = {LCD_CTRL_CMD, cmd};
+    return i2cWrite(lcdDev, data, 2);
+}
+
+// Cursor move (if needed) and the characters in a single transaction
+esp_err_t lcd::sendRun(uint8_t row, uint8_t col, uint8_t len) {
+    static const uint8_t row_offsets[] = {0x00, 0x40};
+    uint8_t buf[2 + 1 + LCD_COLS];
+    size_t n = 0;
+
+    if (hwRow != row || hwCol != col) {
+        buf[n++] = LCD_CTRL_CMD;
+        buf[n++] = 0x80 | (col + row_offsets[row]);
+    }
+    buf[n++] = LCD_CTRL_DATA;
+    memcpy(&buf[n], &fb[row][col], len);
+    n += len;
+
+    esp_err_t ret = i2cWrite(lcdDev, buf, n);
+    if (ret != ESP_OK) {
+        hwRow = hwCol = -1;  // Unknown how much of the run landed
+        return ret;
+    }
+    memcpy(&shown[row][col], &fb[row][col], len);
+    hwRow = row;
+    hwCol = col + len;
+    return ESP_OK;
+}
+
+void lcd::setCursor(uint8_t col, uint8_t row) {
+    curCol = col;
+    curRow = (row < LCD_ROWS) ? row : LCD_ROWS - 1;
+}
+
+void lcd::draw(const char* str) {
+    while (*str && curCol < LCD_COLS) {
+        fb[curRow][curCol++] = *str++;
+    }
+}
+
+// Digits of |value| with an optional decimal point, most significant first;
+// unsigned math so INT32_MIN works
+static size_t formatUnsigned(char* out, uint32_t value, uint8_t base, bool upper, uint8_t decimals) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char tmp[12];
+    size_t n = 0;
+
+    do {
+        if (decimals && n == decimals) {
+            tmp[n++] = '.';
+        }
+        tmp[n++] = digits[value % base];
+        value /= base;
+    } while (value || (decimals && n <= decimals));  // Keeps the "0." of 0.05
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+size_t lcd::format(char* out, size_t size, const char* fmt, va_list ap) {
+    size_t n = 0;
+    if (size == 0) {
+        return 0;
+    }
+
+    while (*fmt && n < size - 1) {
+        if (*fmt != '%') {
+            out[n++] = *fmt++;
+            continue;
+        }
+        fmt++;
+
+        bool left = false, zero = false;
+        for (;; fmt++) {
+            if (*fmt == '-') left = true;
+            else if (*fmt == '0') zero = true;
+            else break;
+        }
+        uint8_t width = 0;
+        while (*fmt >= '0' && *fmt <= '9') {
+            width = width * 10 + (*fmt++ - '0');
+        }
+        if (*fmt == 'l') {
+            fmt++;  // int32_t is long on this target; both are 32 bits
+        }
+
+        char buf[12];
+        const char* text = buf;
+        size_t len = 0;
+        char sign = 0;
+
+        switch (*fmt) {
+        case 'd':
+        case 'i': {
+            int32_t v = va_arg(ap, int32_t);
+            if (v < 0) sign = '-';
+            len = formatUnsigned(buf, v < 0 ? 0U - (uint32_t)v : (uint32_t)v, 10, false, 0);
+            break;
+        }
+        case 'u':
+            len = formatUnsigned(buf, va_arg(ap, uint32_t), 10, false, 0);
+            break;
+        case 'x':
+        case 'X':
+            len = formatUnsigned(buf, va_arg(ap, uint32_t), 16, *fmt == 'X', 0);
+            break;
+        case 'c':
+            buf[0] = (char)va_arg(ap, int);
+            len = 1;
+            break;
+        case 's':
+            text = va_arg(ap, const char*);
+            len = strlen(text);
+            break;
+        case '%':
+            buf[0] = '%';
+            len = 1;
+            break;
+        default:
+            buf[0] = '?';
+            len = 1;
+            if (*fmt == '\0') {
+                fmt--;
+            }
+            break;
+        }
+        fmt++;
+
+        size_t body = len + (sign ? 1 : 0);
+        size_t pad = width > body ? width - body : 0;
+        if (!left && !zero) {
+            while (pad && n < size - 1) { out[n++] = ' '; pad--; }
+        }
+        if (sign && n < size - 1) {
+            out[n++] = sign;
+        }
+        if (!left && zero) {
+            while (pad && n < size - 1) { out[n++] = '0'; pad--; }
+        }
+        for (size_t i = 0; i < len && n < size - 1; i++) {
+            out[n++] = text[i];
+        }
+        while (pad && n < size - 1) { out[n++] = ' '; pad--; }
+    }
+
+    out[n] = '\0';
+    return n;
+}
+
+void lcd::vprintf(const char* fmt, va_list ap) {
+    char buf[LCD_COLS + 1];  // Nothing past the end of a row is visible
+    format(buf, sizeof(buf), fmt, ap);
+    draw(buf);
+}
+
+void lcd::printf(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+void lcd::putFieldText(uint8_t col, uint8_t row, uint8_t width, const char* text, size_t len, bool right) {
+    if (row >= LCD_ROWS || col >= LCD_COLS) {
+        return;
+    }
+    if (width > LCD_COLS - col) {
+        width = LCD_COLS - col;
+    }
+    if (len > width) {
+        len = width;
+    }
+
+    char* cells = &fb[row][col];
+    size_t pad = width - len;
+    memset(cells, ' ', width);
+    memcpy(cells + (right ? pad : 0), text, len);
+}
+
+void lcd::field(uint8_t col, uint8_t row, uint8_t width, int32_t value, uint8_t decimals) {
+    char buf[13];
+    size_t n = 0;
+
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    if (value < 0) {
+        buf[n++] = '-';
+    }
+    n += formatUnsigned(&buf[n], value < 0 ? 0U - (uint32_t)value : (uint32_t)value, 10, false, decimals);
+
+    // Judge the fit on the cells the row has left, or the clip would drop digits
+    if (col < LCD_COLS && width > LCD_COLS - col) {
+        width = LCD_COLS - col;
+    }
+    if (n > width) {
+        memset(buf, '#', width);
+        n = width;
+    }
+    putFieldText(col, row, width, buf, n, true);
+}
+
+void lcd::field(uint8_t col, uint8_t row, uint8_t width, const char* str) {
+    putFieldText(col, row, width, str, strlen(str), false);
+}
+
+void lcd::printstr(const char* str) {
+    draw(str);
+    flush();
+}
+
+// Bitmask of the slots the framebuffer refers to; those can't be evicted
+uint8_t lcd::slotsOnScreen() {
+    uint8_t mask = 0;
+    for (uint8_t row = 0; row < LCD_ROWS; row++) {
+        for (uint8_t col = 0; col < LCD_COLS; col++) {
+            uint8_t c = fb[row][col];
+            if (c < 0x10) {
+                mask |= 1U << (c & 0x07);
+            }
+        }
+    }
+    return mask;
+}
+
+int lcd::glyph(uint16_t id, const uint8_t* bitmap) {
+    if (!bitmap) {
+        if (id >= LCD_GLYPH_BUILTIN_COUNT) {
+            return -1;
+        }
+        bitmap = builtinGlyphs[id];
+    }
+    glyphClock++;
+
+    int victim = -1;
+    for (uint8_t i = 0; i < LCD_CGRAM_SLOTS; i++) {
+        if (slots[i].used && slots[i].id == id) {
+            slots[i].lastUse = glyphClock;
+            return LCD_GLYPH_CHAR(i);
+        }
+        if (!slots[i].used && victim < 0) {
+            victim = i;
+        }
+    }
+
+    if (victim < 0) {
+        uint8_t pinned = slotsOnScreen();
+        for (uint8_t i = 0; i < LCD_CGRAM_SLOTS; i++) {
+            if (pinned & (1U << i)) {
+                continue;
+            }
+            if (victim < 0 || glyphClock - slots[i].lastUse > glyphClock - slots[victim].lastUse) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return -1;
+        }
+    }
+
+    glyphSlot& s = slots[victim];
+    s.id = id;
+    s.used = true;
+    s.dirty = true;
+    s.lastUse = glyphClock;
+    memcpy(s.bitmap, bitmap, LCD_GLYPH_ROWS);
+    return LCD_GLYPH_CHAR(victim);
+}
+
+esp_err_t lcd::drawGlyph(uint16_t id, const uint8_t* bitmap) {
+    int c = glyph(id, bitmap);
+    if (c < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (curCol < LCD_COLS) {
+        fb[curRow][curCol++] = (char)c;
+    }
+    return ESP_OK;
+}
+
+// Full cells come from character ROM, so a bar costs at most one CGRAM slot
+void lcd::drawBar(uint8_t width, uint8_t value, uint8_t max) {
+    uint32_t steps = max ? (uint32_t)(value > max ? max : value) * width * 5 / max : 0;
+
+    for (uint8_t i = 0; i < width && curCol < LCD_COLS; i++) {
+        char c = ' ';
+        if (steps >= 5) {
+            c = LCD_CHAR_FULL_BLOCK;
+            steps -= 5;
+        } else if (steps > 0) {
+            int g = glyph(LCD_GLYPH_BAR1 + steps - 1);
+            c = (g < 0) ? ' ' : (char)g;
+            steps = 0;
+        }
+        fb[curRow][curCol++] = c;
+    }
+}
+
+// Bitmap upload in one transaction: set CGRAM address, then eight data bytes
+esp_err_t lcd::sendGlyph(uint8_t slot) {
+    uint8_t buf[3 + LCD_GLYPH_ROWS] = {LCD_CTRL_CMD, (uint8_t)(0x40 | (slot << 3)), LCD_CTRL_DATA};
+    memcpy(&buf[3], slots[slot].bitmap, LCD_GLYPH_ROWS);
+
+    hwRow = hwCol = -1;  // Address counter now points into CGRAM
+    esp_err_t ret = i2cWrite(lcdDev, buf, sizeof(buf));
+    if (ret == ESP_OK) {
+        slots[slot].dirty = false;
+    }
+    return ret;
+}
+
+esp_err_t lcd::flush() {
+    // Glyphs first, so new cells never show a stale bitmap
+    for (uint8_t i = 0; i < LCD_CGRAM_SLOTS; i++) {
+        if (slots[i].dirty) {
+            esp_err_t ret = sendGlyph(i);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+
+    if (marqueeOn) {
+        return ESP_OK;  // DDRAM holds the marquee; cells stay dirty until it stops
+    }
+
+    for (uint8_t row = 0; row < LCD_ROWS; row++) {
+        uint8_t col = 0;
+        while (col < LCD_COLS) {
+            if (fb[row][col] == shown[row][col]) {
+                col++;
+                continue;
+            }
+            // Extend the run over short clean gaps; the address counter
+            // advances by itself, so the run needs at most one cursor move
+            uint8_t start = col;
+            uint8_t end = col + 1;
+            for (uint8_t i = end; i < LCD_COLS && i - end <= LCD_RUN_MERGE_GAP; i++) {
+                if (fb[row][i] != shown[row][i]) {
+                    end = i + 1;
+                }
+            }
+            esp_err_t ret = sendRun(row, start, end - start);
+            if (ret != ESP_OK) {
+                return ret;  // Cells stay dirty and go out with the next flush
+            }
+            col = end;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t lcd::setReg(uint8_t reg, uint8_t data) {
+    if ((rgbKnown & (1U << reg)) && rgbShadow[reg] == data) {
+        return ESP_OK;
+    }
+
+    uint8_t buffer[2] = {reg, data};
+    esp_err_t ret = i2cWrite(rgbDev, buffer, 2);
+    if (ret != ESP_OK) {
+        rgbKnown &= ~(1U << reg);
+        return ret;
+    }
+    rgbShadow[reg] = data;
+    rgbKnown |= 1U << reg;
+    return ESP_OK;
+}
+
+esp_err_t lcd::setRGB(uint8_t r, uint8_t g, uint8_t b) {
+    esp_err_t ret = setReg(RGB_REG_RED, r);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_GREEN, g);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_BLUE, b);
+    return ret;
+}
+
+// Group dimming: GRPPWM scales every channel at ~190 Hz
+esp_err_t lcd::setBrightness(uint8_t level) {
+    brightness = level;
+    esp_err_t ret = setReg(RGB_REG_MODE2, 0x00);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_GRPPWM, level);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_LEDOUT, level == 0xFF ? RGB_LEDOUT_PWM : RGB_LEDOUT_GROUP);
+    return ret;
+}
+
+// Group blinking: the controller toggles the backlight itself, no bus traffic per cycle
+esp_err_t lcd::blinkBacklight(uint16_t periodMs, uint8_t dutyPercent) {
+    if (periodMs == 0) {
+        return setBrightness(brightness);  // Back to dimming, at the level blinking replaced
+    }
+
+    uint32_t freq = (uint32_t)periodMs * 24 / 1000;
+    freq = (freq == 0) ? 0 : (freq > 256 ? 255 : freq - 1);
+    uint32_t duty = (dutyPercent >= 100) ? 255 : (uint32_t)dutyPercent * 256 / 100;
+
+    esp_err_t ret = setReg(RGB_REG_GRPFREQ, freq);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_GRPPWM, duty);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_MODE2, RGB_MODE2_DMBLNK);
+    if (ret == ESP_OK) ret = setReg(RGB_REG_LEDOUT, RGB_LEDOUT_GROUP);
+    return ret;
+}
+
+esp_err_t lcd::setMarqueeText(uint8_t row, const char* text) {
+    if (row >= LCD_ROWS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t len = strnlen(text, LCD_DDRAM_COLS);
+    memset(marqueeText[row], ' ', LCD_DDRAM_COLS);
+    memcpy(marqueeText[row], text, len);
+    return marqueeOn ? sendMarqueeRow(row) : ESP_OK;
+}
+
+// The whole 40-column row in one transaction
+esp_err_t lcd::sendMarqueeRow(uint8_t row) {
+    static const uint8_t row_offsets[] = {0x00, 0x40};
+    uint8_t buf[3 + LCD_DDRAM_COLS] = {LCD_CTRL_CMD, (uint8_t)(0x80 | row_offsets[row]), LCD_CTRL_DATA};
+    memcpy(&buf[3], marqueeText[row], LCD_DDRAM_COLS);
+
+    hwRow = hwCol = -1;  // Counter ran off the visible columns
+    return i2cWrite(lcdDev, buf, sizeof(buf));
+}
+
+esp_err_t lcd::marqueeStart(uint16_t stepMs) {
+    if (stepMs == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!marqueeTimer) {
+        marqueeLock = xSemaphoreCreateMutex();
+        if (!marqueeLock) {
+            return ESP_ERR_NO_MEM;
+        }
+        esp_timer_create_args_t args = {};
+        args.callback = marqueeStep;
+        args.arg = this;
+        args.name = "lcd_marquee";
+        args.skip_unhandled_events = true;
+        esp_err_t ret = esp_timer_create(&args, &marqueeTimer);
+        if (ret != ESP_OK) {
+            vSemaphoreDelete(marqueeLock);
+            marqueeLock = nullptr;
+            return ret;
+        }
+    }
+
+    if (marqueeOn) {
+        esp_timer_stop(marqueeTimer);  // Only the speed changes
+    } else {
+        for (uint8_t row = 0; row < LCD_ROWS; row++) {
+            esp_err_t ret = sendMarqueeRow(row);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        marqueeOn = true;
+    }
+    return esp_timer_start_periodic(marqueeTimer, (uint64_t)stepMs * 1000);
+}
+
+esp_err_t lcd::marqueeStop() {
+    if (!marqueeOn) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(marqueeLock, portMAX_DELAY);
+    marqueeOn = false;
+    esp_timer_stop(marqueeTimer);
+    xSemaphoreGive(marqueeLock);
+
+    // Return home undoes the shift; the framebuffer is redrawn in full next flush
+    esp_err_t ret = sendCommand(0x02);
+    vTaskDelay(pdMS_TO_TICKS(2));
+    memset(shown, 0, sizeof(shown));
+    hwRow = hwCol = (ret == ESP_OK) ? 0 : -1;
+    return ret;
+}
+
+// esp_timer task: one display-shift-left command per step
+void lcd::marqueeStep(void* arg) {
+    lcd* self = static_cast<lcd*>(arg);
+
+    if (xSemaphoreTake(self->marqueeLock, 0) != pdTRUE) {
+        return;  // Being stopped
+    }
+    if (self->marqueeOn) {
+        self->sendCommand(0x18);
+    }
+    xSemaphoreGive(self->marqueeLock);
+}
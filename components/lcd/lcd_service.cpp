@@ -0,0 +1,285 @@
+#include "lcd_service.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "LCD_SERVICE";
+
+lcd_service::lcd_service(lcd& display, size_t queueLen)
+    : display(display), queueLen(queueLen), queue(nullptr), task(nullptr), doneSem(nullptr), stats() {
+    portMUX_INITIALIZE(&lock);
+}
+
+lcd_service::~lcd_service() {
+    stop();
+}
+
+esp_err_t lcd_service::start(UBaseType_t priority, uint32_t stackSize) {
+    if (task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    queue = xQueueCreate(queueLen, sizeof(msg));
+    doneSem = xSemaphoreCreateBinary();
+    if (!queue || !doneSem ||
+        xTaskCreate(taskEntry, "lcd_service", stackSize, this, priority, &task) != pdPASS) {
+        if (queue) vQueueDelete(queue);
+        if (doneSem) vSemaphoreDelete(doneSem);
+        queue = nullptr;
+        doneSem = nullptr;
+        task = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void lcd_service::stop() {
+    if (!task) {
+        return;
+    }
+
+    msg m = {};
+    m.type = op::stop;
+    xQueueSend(queue, &m, portMAX_DELAY);
+    xSemaphoreTake(doneSem, portMAX_DELAY);
+
+    vQueueDelete(queue);
+    vSemaphoreDelete(doneSem);
+    queue = nullptr;
+    doneSem = nullptr;
+    task = nullptr;
+}
+
+bool lcd_service::print(uint8_t col, uint8_t row, const char* str, TickType_t wait) {
+    msg m = {};
+    m.type = op::print;
+    m.col = col;
+    m.row = row;
+    strncpy(m.text, str, LCD_COLS);
+    return post(m, wait);
+}
+
+bool lcd_service::printf(uint8_t col, uint8_t row, const char* fmt, ...) {
+    msg m = {};
+    m.type = op::print;
+    m.col = col;
+    m.row = row;
+
+    va_list ap;
+    va_start(ap, fmt);
+    lcd::format(m.text, sizeof(m.text), fmt, ap);
+    va_end(ap);
+    return post(m, 0);
+}
+
+bool lcd_service::field(uint8_t col, uint8_t row, uint8_t width, int32_t value, uint8_t decimals, TickType_t wait) {
+    msg m = {};
+    m.type = op::field;
+    m.col = col;
+    m.row = row;
+    m.r = width;
+    m.g = decimals;
+    m.value = value;
+    return post(m, wait);
+}
+
+bool lcd_service::drawGlyph(uint8_t col, uint8_t row, uint16_t id, const uint8_t* bitmap, TickType_t wait) {
+    msg m = {};
+    m.type = op::glyph;
+    m.col = col;
+    m.row = row;
+    m.glyphId = id;
+    if (bitmap) {
+        m.hasBitmap = true;
+        memcpy(m.text, bitmap, LCD_GLYPH_ROWS);
+    }
+    return post(m, wait);
+}
+
+bool lcd_service::drawBar(uint8_t col, uint8_t row, uint8_t width, uint8_t value, uint8_t max, TickType_t wait) {
+    msg m = {};
+    m.type = op::bar;
+    m.col = col;
+    m.row = row;
+    m.r = width;
+    m.g = value;
+    m.b = max;
+    return post(m, wait);
+}
+
+bool lcd_service::setMarqueeText(uint8_t row, const char* text, TickType_t wait) {
+    msg m = {};
+    m.type = op::marqueeText;
+    m.row = row;
+    strncpy(m.text, text, LCD_DDRAM_COLS);
+    return post(m, wait);
+}
+
+bool lcd_service::marqueeStart(uint16_t stepMs, TickType_t wait) {
+    msg m = {};
+    m.type = op::marqueeStart;
+    m.periodMs = stepMs;
+    return post(m, wait);
+}
+
+bool lcd_service::marqueeStop(TickType_t wait) {
+    msg m = {};
+    m.type = op::marqueeStop;
+    return post(m, wait);
+}
+
+bool lcd_service::clear(TickType_t wait) {
+    msg m = {};
+    m.type = op::clear;
+    return post(m, wait);
+}
+
+bool lcd_service::setRGB(uint8_t r, uint8_t g, uint8_t b, TickType_t wait) {
+    msg m = {};
+    m.type = op::rgb;
+    m.r = r;
+    m.g = g;
+    m.b = b;
+    return post(m, wait);
+}
+
+bool lcd_service::setBrightness(uint8_t level, TickType_t wait) {
+    msg m = {};
+    m.type = op::brightness;
+    m.r = level;
+    return post(m, wait);
+}
+
+bool lcd_service::blinkBacklight(uint16_t periodMs, uint8_t dutyPercent, TickType_t wait) {
+    msg m = {};
+    m.type = op::blink;
+    m.periodMs = periodMs;
+    m.r = dutyPercent;
+    return post(m, wait);
+}
+
+void lcd_service::getStats(lcd_service_stats_t* out) {
+    portENTER_CRITICAL(&lock);
+    *out = stats;
+    portEXIT_CRITICAL(&lock);
+    out->queueDepth = queue ? uxQueueMessagesWaiting(queue) : 0;
+}
+
+bool lcd_service::post(msg& m, TickType_t wait) {
+    if (!task) {
+        return false;
+    }
+
+    m.postedUs = esp_timer_get_time();
+    bool ok = xQueueSend(queue, &m, wait) == pdTRUE;
+    UBaseType_t depth = uxQueueMessagesWaiting(queue);
+
+    portENTER_CRITICAL(&lock);
+    if (ok) {
+        stats.posted++;
+    } else {
+        stats.dropped++;
+    }
+    if (depth > stats.maxQueueDepth) {
+        stats.maxQueueDepth = depth;
+    }
+    portEXIT_CRITICAL(&lock);
+    return ok;
+}
+
+void lcd_service::taskEntry(void* arg) {
+    static_cast<lcd_service*>(arg)->run();
+}
+
+void lcd_service::run() {
+    msg m;
+
+    while (xQueueReceive(queue, &m, portMAX_DELAY) == pdTRUE && m.type != op::stop) {
+        // Apply everything already queued, then put it on the bus in one flush
+        int64_t oldestUs = m.postedUs;
+        bool stopping = false;
+        do {
+            if (m.type == op::stop) {
+                stopping = true;
+                break;
+            }
+            esp_err_t ret = apply(m);
+            if (m.type == op::glyph && ret != ESP_OK) {
+                ESP_LOGD(TAG, "No free CGRAM slot for glyph %u", m.glyphId);
+            } else if (m.type != op::print && m.type != op::field &&
+                       m.type != op::glyph && m.type != op::bar) {
+                record(ret);  // Drawing only reaches the bus in flush()
+            }
+        } while (xQueueReceive(queue, &m, 0) == pdTRUE);
+
+        record(display.flush());
+        uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - oldestUs);
+
+        portENTER_CRITICAL(&lock);
+        stats.flushes++;
+        stats.lastLatencyUs = latencyUs;
+        if (latencyUs > stats.maxLatencyUs) {
+            stats.maxLatencyUs = latencyUs;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (stopping) {
+            break;
+        }
+    }
+
+    xSemaphoreGive(doneSem);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t lcd_service::apply(const msg& m) {
+    switch (m.type) {
+    case op::print:
+        display.setCursor(m.col, m.row);
+        display.draw(m.text);
+        return ESP_OK;
+    case op::field:
+        display.field(m.col, m.row, m.r, m.value, m.g);
+        return ESP_OK;
+    case op::glyph:
+        display.setCursor(m.col, m.row);
+        return display.drawGlyph(m.glyphId, m.hasBitmap ? (const uint8_t*)m.text : nullptr);
+    case op::bar:
+        display.setCursor(m.col, m.row);
+        display.drawBar(m.r, m.g, m.b);
+        return ESP_OK;
+    case op::marqueeText:
+        return display.setMarqueeText(m.row, m.text);
+    case op::marqueeStart:
+        return display.marqueeStart(m.periodMs);
+    case op::marqueeStop:
+        return display.marqueeStop();
+    case op::clear:
+        return display.clear();
+    case op::rgb:
+        return display.setRGB(m.r, m.g, m.b);
+    case op::brightness:
+        return display.setBrightness(m.r);
+    case op::blink:
+        return display.blinkBacklight(m.periodMs, m.r);
+    default:
+        return ESP_OK;
+    }
+}
+
+// Count every failure but only log when the display goes from working to failing
+void lcd_service::record(esp_err_t ret) {
+    bool wasOk;
+
+    portENTER_CRITICAL(&lock);
+    wasOk = (stats.lastError == ESP_OK);
+    if (ret != ESP_OK) {
+        stats.errors++;
+    }
+    stats.lastError = ret;
+    portEXIT_CRITICAL(&lock);
+
+    if (ret != ESP_OK && wasOk) {
+        ESP_LOGW(TAG, "Display write failed: %s", esp_err_to_name(ret));
+    }
+}
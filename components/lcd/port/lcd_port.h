@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lcd.h"
+
+// Bus glue between the lcd class and the transport it runs on.
+// lcd_port_i2c.cpp talks to the I2C master driver, lcd_port_sim.cpp to the
+// simulated display used by the linux target build.
+
+esp_err_t lcd_port_add_device(lcd_bus_handle_t bus, uint8_t addr, uint32_t sclHz, lcd_port_dev_t* dev);
+void lcd_port_rm_device(lcd_port_dev_t dev);
+esp_err_t lcd_port_write(lcd_port_dev_t dev, const uint8_t* data, size_t len);
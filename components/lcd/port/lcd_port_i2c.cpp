@@ -0,0 +1,18 @@
+#include "lcd_port.h"
+
+esp_err_t lcd_port_add_device(lcd_bus_handle_t bus, uint8_t addr, uint32_t sclHz, lcd_port_dev_t* dev) {
+    i2c_device_config_t cfg = {};
+    cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    cfg.device_address = addr;
+    cfg.scl_speed_hz = sclHz;
+    return i2c_master_bus_add_device(bus, &cfg, (i2c_master_dev_handle_t*)dev);
+}
+
+void lcd_port_rm_device(lcd_port_dev_t dev) {
+    i2c_master_bus_rm_device((i2c_master_dev_handle_t)dev);
+}
+
+// One transaction per call; the bus driver allocates nothing per write
+esp_err_t lcd_port_write(lcd_port_dev_t dev, const uint8_t* data, size_t len) {
+    return i2c_master_transmit((i2c_master_dev_handle_t)dev, data, len, LCD_I2C_TIMEOUT_MS);
+}
@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include "lcd_port.h"
+#include "lcd_sim.h"
+
+#define SIM_BITS_PER_BYTE   9   // 8 data bits + ACK
+#define SIM_BITS_OVERHEAD   2   // START + STOP
+
+#define SIM_RGB_REGS        16
+
+struct lcd_sim_dev_t {
+    struct lcd_sim_t* sim;
+    uint8_t addr;
+    uint32_t sclHz;
+};
+
+struct lcd_sim_t {
+    lcd_sim_dev_t lcdDev;
+    lcd_sim_dev_t rgbDev;
+
+    // Text controller
+    char ddram[2][LCD_SIM_DDRAM_COLS];
+    uint8_t cgram[8][8];
+    bool cgramMode;         // Data goes to CGRAM until the next DDRAM address
+    uint8_t ac;             // Address counter, DDRAM (row << 6 | col) or CGRAM (0..63)
+    bool extended;          // Function set IS=1: 0x10-0x7F are extended instructions
+    bool displayOn;
+    int shift;
+
+    uint8_t rgbRegs[SIM_RGB_REGS];
+
+    uint32_t nacksPending;
+    lcd_sim_stats_t stats;
+};
+
+static bool simAccount(lcd_sim_dev_t* dev, size_t len) {
+    lcd_sim_t* sim = dev->sim;
+    bool acked = true;
+
+    if (sim->nacksPending) {
+        sim->nacksPending--;
+        acked = false;
+    }
+    sim->stats.transactions++;
+    sim->stats.busTimeUs += ((1 + (acked ? len : 0)) * SIM_BITS_PER_BYTE + SIM_BITS_OVERHEAD) * 1000000ULL / dev->sclHz;
+    if (!acked) {
+        sim->stats.nacks++;
+        return false;
+    }
+    sim->stats.bytesWritten += len;
+    return true;
+}
+
+// DDRAM counter runs 0x00-0x27 then 0x40-0x67 and wraps back to 0x00
+static void simAdvance(lcd_sim_t* sim) {
+    if (sim->cgramMode) {
+        sim->ac = (sim->ac + 1) & 0x3F;
+        return;
+    }
+    uint8_t row = sim->ac >> 6;
+    uint8_t col = (sim->ac & 0x3F) + 1;
+    if (col >= LCD_SIM_DDRAM_COLS) {
+        col = 0;
+        row ^= 1;
+    }
+    sim->ac = (row << 6) | col;
+}
+
+static void simCommand(lcd_sim_t* sim, uint8_t cmd) {
+    if (cmd & 0x80) {
+        uint8_t col = cmd & 0x3F;
+        sim->ac = (cmd & 0x40) | (col < LCD_SIM_DDRAM_COLS ? col : 0);
+        sim->cgramMode = false;
+    } else if (cmd & 0x40) {
+        if (!sim->extended) {
+            sim->ac = cmd & 0x3F;
+            sim->cgramMode = true;
+        }  // else icon address, power/contrast or follower control
+    } else if (cmd & 0x20) {
+        sim->extended = cmd & 0x01;
+    } else if (cmd & 0x10) {
+        if (!sim->extended && (cmd & 0x08)) {  // Display shift; cursor-only moves aren't modelled
+            sim->shift = (sim->shift + ((cmd & 0x04) ? LCD_SIM_DDRAM_COLS - 1 : 1)) % LCD_SIM_DDRAM_COLS;
+        }  // else internal oscillator frequency
+    } else if (cmd & 0x08) {
+        sim->displayOn = cmd & 0x04;
+    } else if (cmd & 0x04) {
+        // Entry mode; the driver only uses increment without shift
+    } else if (cmd & 0x02) {
+        sim->ac = 0;
+        sim->cgramMode = false;
+        sim->shift = 0;
+    } else if (cmd & 0x01) {
+        memset(sim->ddram, ' ', sizeof(sim->ddram));
+        sim->ac = 0;
+        sim->cgramMode = false;
+        sim->shift = 0;
+    }
+}
+
+static void simData(lcd_sim_t* sim, uint8_t data) {
+    if (sim->cgramMode) {
+        sim->cgram[sim->ac >> 3][sim->ac & 0x07] = data & 0x1F;
+    } else {
+        sim->ddram[sim->ac >> 6][sim->ac & 0x3F] = (char)data;
+    }
+    simAdvance(sim);
+}
+
+// Control byte: Co (bit 7) set means one byte follows and then another control
+// byte; clear means the rest of the transfer is commands or data per RS (bit 6)
+static void simLcdWrite(lcd_sim_t* sim, const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i + 1 < len) {
+        bool more = data[i] & 0x80;
+        bool rs = data[i] & 0x40;
+        i++;
+        do {
+            if (rs) {
+                simData(sim, data[i]);
+            } else {
+                simCommand(sim, data[i]);
+            }
+            i++;
+        } while (!more && i < len);
+    }
+}
+
+// Control byte: register in the low nibble, auto-increment if bit 7 is set
+static void simRgbWrite(lcd_sim_t* sim, const uint8_t* data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    uint8_t reg = data[0] & 0x0F;
+    bool autoInc = data[0] & 0x80;
+    for (size_t i = 1; i < len; i++) {
+        sim->rgbRegs[reg] = data[i];
+        if (autoInc) {
+            reg = (reg + 1) % SIM_RGB_REGS;
+        }
+    }
+}
+
+esp_err_t lcd_sim_create(lcd_sim_handle_t* simRet) {
+    lcd_sim_t* sim = (lcd_sim_t*)calloc(1, sizeof(lcd_sim_t));
+    if (!sim) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(sim->ddram, ' ', sizeof(sim->ddram));
+    sim->lcdDev.sim = sim;
+    sim->lcdDev.addr = LCD_ADDRESS;
+    sim->rgbDev.sim = sim;
+    sim->rgbDev.addr = RGB_ADDRESS;
+    sim->rgbRegs[RGB_REG_MODE1] = 0x11;  // Power-on default: asleep
+    *simRet = sim;
+    return ESP_OK;
+}
+
+void lcd_sim_delete(lcd_sim_handle_t sim) {
+    free(sim);
+}
+
+void lcd_sim_get_row(lcd_sim_handle_t sim, uint8_t row, char out[17]) {
+    for (int col = 0; col < LCD_COLS; col++) {
+        out[col] = sim->ddram[row & 1][(col + sim->shift) % LCD_SIM_DDRAM_COLS];
+    }
+    out[LCD_COLS] = '\0';
+}
+
+void lcd_sim_get_glyph(lcd_sim_handle_t sim, uint8_t slot, uint8_t bitmap[8]) {
+    memcpy(bitmap, sim->cgram[slot & 0x07], 8);
+}
+
+bool lcd_sim_display_on(lcd_sim_handle_t sim) {
+    return sim->displayOn;
+}
+
+int lcd_sim_get_shift(lcd_sim_handle_t sim) {
+    return sim->shift;
+}
+
+void lcd_sim_get_backlight(lcd_sim_handle_t sim, lcd_sim_backlight_t* out) {
+    const uint8_t* regs = sim->rgbRegs;
+    out->r = regs[RGB_REG_RED];
+    out->g = regs[RGB_REG_GREEN];
+    out->b = regs[RGB_REG_BLUE];
+    out->groupEnabled = regs[RGB_REG_LEDOUT] == RGB_LEDOUT_GROUP;
+    out->blinking = regs[RGB_REG_MODE2] & RGB_MODE2_DMBLNK;
+    out->groupPwm = regs[RGB_REG_GRPPWM];
+    out->blinkPeriodMs = (uint16_t)((regs[RGB_REG_GRPFREQ] + 1) * 1000 / 24);
+    out->asleep = regs[RGB_REG_MODE1] & 0x10;
+}
+
+void lcd_sim_inject_nack(lcd_sim_handle_t sim, uint32_t count) {
+    sim->nacksPending = count;
+}
+
+void lcd_sim_get_stats(lcd_sim_handle_t sim, lcd_sim_stats_t* stats) {
+    *stats = sim->stats;
+}
+
+void lcd_sim_reset_stats(lcd_sim_handle_t sim) {
+    memset(&sim->stats, 0, sizeof(sim->stats));
+}
+
+esp_err_t lcd_port_add_device(lcd_bus_handle_t bus, uint8_t addr, uint32_t sclHz, lcd_port_dev_t* dev) {
+    lcd_sim_dev_t* d = (addr == LCD_ADDRESS) ? &bus->lcdDev : (addr == RGB_ADDRESS) ? &bus->rgbDev : nullptr;
+    if (!d) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    d->sclHz = sclHz;
+    *dev = d;
+    return ESP_OK;
+}
+
+void lcd_port_rm_device(lcd_port_dev_t dev) {
+    (void)dev;
+}
+
+esp_err_t lcd_port_write(lcd_port_dev_t dev, const uint8_t* data, size_t len) {
+    lcd_sim_dev_t* d = (lcd_sim_dev_t*)dev;
+
+    if (!simAccount(d, len)) {
+        return ESP_FAIL;
+    }
+    if (d->addr == LCD_ADDRESS) {
+        simLcdWrite(d->sim, data, len);
+    } else {
+        simRgbWrite(d->sim, data, len);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,190 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "shtc3.h"
+#include "shtc3_crc.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_cpu.h"
+#endif
+
+#define BENCH_FRAMES        200000
+#define BENCH_FRAME_POOL    256     /* Distinct frames cycled through, so nothing is constant-folded */
+#define BENCH_FRAME_WORDS   2       /* A measurement: temperature and humidity */
+#define BENCH_SAMPLES       100000
+
+#define CRC_POLY            0x31
+#define CRC_INIT            0xFF
+
+typedef struct {
+    int64_t start_us;
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_cpu_cycle_count_t start_cycles;
+#endif
+} bench_timer_t;
+
+static uint8_t s_frames[BENCH_FRAME_POOL][BENCH_FRAME_WORDS * SHTC3_CRC_WORD_SIZE];
+static volatile uint32_t s_sink;
+
+/* The bit-by-bit loop shtc3_crc8() replaced */
+static uint8_t crc8_bitwise(const uint8_t *data, size_t len)
+{
+    uint8_t crc = CRC_INIT;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ CRC_POLY : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* The per-word check and unpack shtc3_crc_unpack() replaced */
+static esp_err_t unpack_bitwise(const uint8_t *frame, size_t word_count, uint16_t *words)
+{
+    for (size_t i = 0; i < word_count; i++) {
+        const uint8_t *word = &frame[i * SHTC3_CRC_WORD_SIZE];
+        if (crc8_bitwise(word, 2) != word[2]) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        words[i] = (uint16_t)((word[0] << 8) | word[1]);
+    }
+    return ESP_OK;
+}
+
+/* The labs' conversions before the fixed-point API: double expressions stored to float, then rounded */
+static void convert_double(uint16_t raw_temp, uint16_t raw_humidity, int32_t out[3])
+{
+    float temp_c = -45 + 175 * (raw_temp / 65535.0);
+    float temp_f = temp_c * 9.0 / 5.0 + 32.0;
+    float humidity = 100 * (raw_humidity / 65535.0);
+
+    out[0] = (int32_t) round(temp_c * 100);
+    out[1] = (int32_t) round(temp_f * 100);
+    out[2] = (int32_t) round(humidity * 100);
+}
+
+static void convert_fixed(uint16_t raw_temp, uint16_t raw_humidity, int32_t out[3])
+{
+    out[0] = shtc3_temp_c_fixed(raw_temp, SHTC3_SCALE_CENTI);
+    out[1] = shtc3_temp_f_fixed(raw_temp, SHTC3_SCALE_CENTI);
+    out[2] = shtc3_humidity_fixed(raw_humidity, SHTC3_SCALE_CENTI);
+}
+
+static void bench_start(bench_timer_t *timer)
+{
+    timer->start_us = esp_timer_get_time();
+#if !CONFIG_IDF_TARGET_LINUX
+    timer->start_cycles = esp_cpu_get_cycle_count();
+#endif
+}
+
+/* Time per call; on a chip also CPU cycles per call */
+static void bench_stop(const bench_timer_t *timer, const char *name, uint32_t count)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_cpu_cycle_count_t cycles = esp_cpu_get_cycle_count() - timer->start_cycles;
+#endif
+    int64_t elapsed_us = esp_timer_get_time() - timer->start_us;
+
+    printf("%-28s %8.1f ns/call %8.2f M calls/s", name,
+           elapsed_us * 1000.0 / count, count / (double) elapsed_us);
+#if !CONFIG_IDF_TARGET_LINUX
+    printf(" %8.1f cycles/call", (double) cycles / count);
+#endif
+    printf("\n");
+}
+
+static void make_frames(void)
+{
+    srand(1);
+    for (size_t f = 0; f < BENCH_FRAME_POOL; f++) {
+        for (size_t w = 0; w < BENCH_FRAME_WORDS; w++) {
+            uint8_t *word = &s_frames[f][w * SHTC3_CRC_WORD_SIZE];
+            word[0] = rand() & 0xFF;
+            word[1] = rand() & 0xFF;
+            word[2] = crc8_bitwise(word, 2);
+        }
+    }
+}
+
+static void bench_crc(void)
+{
+    uint16_t words[BENCH_FRAME_WORDS];
+    uint32_t sum;
+    bench_timer_t timer;
+
+    // Every possible data word, before any timing
+    for (uint32_t v = 0; v <= UINT16_MAX; v++) {
+        uint8_t word[2] = { (uint8_t)(v >> 8), (uint8_t)(v & 0xFF) };
+        if (shtc3_crc8(word, 2) != crc8_bitwise(word, 2)) {
+            printf("CRC mismatch at 0x%04" PRIx32 "\n", v);
+            abort();
+        }
+    }
+    printf("CRC-8: all 65536 words match the bitwise loop\n");
+
+    make_frames();
+
+    sum = 0;
+    bench_start(&timer);
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        sum += unpack_bitwise(s_frames[i % BENCH_FRAME_POOL], BENCH_FRAME_WORDS, words) + words[0];
+    }
+    bench_stop(&timer, "frame check, bitwise", BENCH_FRAMES);
+    s_sink = sum;
+
+    sum = 0;
+    bench_start(&timer);
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        sum += shtc3_crc_unpack(s_frames[i % BENCH_FRAME_POOL], BENCH_FRAME_WORDS, words) + words[0];
+    }
+    bench_stop(&timer, "frame check, shtc3_crc", BENCH_FRAMES);
+    s_sink = sum;
+}
+
+static void bench_conversions(void)
+{
+    int32_t out[3];
+    uint32_t sum;
+    uint32_t mismatches = 0;
+    bench_timer_t timer;
+
+    // Exact datasheet value, rounded; the lab expressions miss it by a step now and then
+    for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+        convert_fixed(raw, raw, out);
+        mismatches += out[0] != (int32_t) lround(-4500.0 + 17500.0 * raw / 65535.0);
+        mismatches += out[1] != (int32_t) lround(-4900.0 + 31500.0 * raw / 65535.0);
+        mismatches += out[2] != (int32_t) lround(10000.0 * raw / 65535.0);
+    }
+    printf("Fixed point: %" PRIu32 " of 196608 values differ from the exact rounded result\n", mismatches);
+
+    // Raw words step through the whole range with an odd stride
+    sum = 0;
+    bench_start(&timer);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        convert_double(i * 40503U, i * 30011U, out);
+        sum += out[0] + out[1] + out[2];
+    }
+    bench_stop(&timer, "C, F and RH, lab double", BENCH_SAMPLES);
+    s_sink = sum;
+
+    sum = 0;
+    bench_start(&timer);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        convert_fixed(i * 40503U, i * 30011U, out);
+        sum += out[0] + out[1] + out[2];
+    }
+    bench_stop(&timer, "C, F and RH, fixed point", BENCH_SAMPLES);
+    s_sink = sum;
+}
+
+void app_main(void)
+{
+    bench_crc();
+    bench_conversions();
+}
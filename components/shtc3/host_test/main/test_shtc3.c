@@ -0,0 +1,251 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "shtc3.h"
+
+#define SIM_SCL_HZ          100000
+#define SIM_RAW_TEMP        0x6666      /* 25 C */
+#define SIM_RAW_HUMIDITY    0x8000      /* 50 %RH */
+
+/* Generous bound for a timer that should have fired after one conversion */
+#define READY_TIMEOUT       pdMS_TO_TICKS(SHTC3_MEAS_TIME_NORMAL_US / 1000 + 20)
+
+/* Holds the esp_timer task well past shtc3_measure()'s own timeout */
+#define TIMER_TASK_HOLD_MS  (SHTC3_MEAS_TIME_NORMAL_US / 1000 + 100)
+
+static shtc3_sim_handle_t s_sim;
+static shtc3_handle_t s_sensor;
+static atomic_int s_ready_calls;
+
+static void sensor_open(bool auto_sleep)
+{
+    const shtc3_config_t config = {
+        .dev_addr = SHTC3_I2C_ADDRESS,
+        .auto_sleep = auto_sleep,
+    };
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_sim_create(SIM_SCL_HZ, &s_sim));
+    shtc3_sim_set_raw(s_sim, SIM_RAW_TEMP, SIM_RAW_HUMIDITY);
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_create(s_sim, &config, &s_sensor));
+}
+
+static void sensor_close(void)
+{
+    shtc3_delete(s_sensor);
+    shtc3_sim_delete(s_sim);
+}
+
+static uint32_t sim_transactions(void)
+{
+    shtc3_sim_stats_t stats;
+
+    shtc3_sim_get_stats(s_sim, &stats);
+    return stats.transactions;
+}
+
+static void count_ready(shtc3_handle_t sensor, void *user_ctx)
+{
+    atomic_fetch_add(&s_ready_calls, 1);
+}
+
+static void hold_timer_task(void *arg)
+{
+    vTaskDelay(pdMS_TO_TICKS(TIMER_TASK_HOLD_MS));
+}
+
+TEST_CASE("polling mode goes idle, measuring, ready, idle", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    sensor_open(true);
+    TEST_ASSERT_EQUAL(SHTC3_STATE_IDLE, shtc3_get_state(s_sensor));
+
+    int64_t start_us = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_start_measurement(s_sensor, SHTC3_MODE_NORMAL_T_FIRST));
+    TEST_ASSERT_EQUAL(SHTC3_STATE_MEASURING, shtc3_get_state(s_sensor));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, shtc3_collect(s_sensor, &value));
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_wait_ready(s_sensor, READY_TIMEOUT));
+    TEST_ASSERT_GREATER_OR_EQUAL(SHTC3_MEAS_TIME_NORMAL_US, esp_timer_get_time() - start_us);
+    TEST_ASSERT_EQUAL(SHTC3_STATE_READY, shtc3_get_state(s_sensor));
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_collect(s_sensor, &value));
+    TEST_ASSERT_EQUAL_HEX16(SIM_RAW_TEMP, value.temp);
+    TEST_ASSERT_EQUAL_HEX16(SIM_RAW_HUMIDITY, value.humidity);
+    TEST_ASSERT_EQUAL(SHTC3_STATE_IDLE, shtc3_get_state(s_sensor));
+    sensor_close();
+}
+
+TEST_CASE("calls out of order are rejected", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    sensor_open(true);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, shtc3_collect(s_sensor, &value));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, shtc3_wait_ready(s_sensor, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, shtc3_start_measurement(s_sensor, SHTC3_MODE_MAX));
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_start_measurement(s_sensor, SHTC3_MODE_NORMAL_T_FIRST));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, shtc3_start_measurement(s_sensor, SHTC3_MODE_NORMAL_T_FIRST));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, shtc3_sleep(s_sensor));
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_wait_ready(s_sensor, READY_TIMEOUT));
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_collect(s_sensor, &value));
+    sensor_close();
+}
+
+TEST_CASE("wait_ready times out while the sensor converts", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    sensor_open(true);
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_start_measurement(s_sensor, SHTC3_MODE_NORMAL_T_FIRST));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, shtc3_wait_ready(s_sensor, 0));
+    TEST_ASSERT_EQUAL(SHTC3_STATE_MEASURING, shtc3_get_state(s_sensor));
+
+    // A timeout leaves the measurement pending; it can still be collected
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_wait_ready(s_sensor, READY_TIMEOUT));
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_collect(s_sensor, &value));
+    TEST_ASSERT_EQUAL(SHTC3_STATE_IDLE, shtc3_get_state(s_sensor));
+    sensor_close();
+}
+
+TEST_CASE("stretch modes are ready at once and hold the bus until the conversion ends", "[shtc3]")
+{
+    static const shtc3_mode_t modes[] = {
+        SHTC3_MODE_NORMAL_T_FIRST_STRETCH,
+        SHTC3_MODE_LP_T_FIRST_STRETCH,
+    };
+    shtc3_raw_value_t value;
+    shtc3_sim_stats_t stats;
+
+    sensor_open(false);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        int64_t start_us = esp_timer_get_time();
+        TEST_ASSERT_EQUAL(ESP_OK, shtc3_start_measurement(s_sensor, modes[i]));
+        TEST_ASSERT_EQUAL(SHTC3_STATE_READY, shtc3_get_state(s_sensor));
+        TEST_ASSERT_EQUAL(ESP_OK, shtc3_wait_ready(s_sensor, 0));
+
+        TEST_ASSERT_EQUAL(ESP_OK, shtc3_collect(s_sensor, &value));
+        TEST_ASSERT_GREATER_OR_EQUAL(shtc3_get_meas_time_us(modes[i]), esp_timer_get_time() - start_us);
+        TEST_ASSERT_EQUAL_HEX16(SIM_RAW_TEMP, value.temp);
+    }
+
+    // The sensor stretched the clock instead of NACKing an early read
+    shtc3_sim_get_stats(s_sim, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.nacks);
+    sensor_close();
+}
+
+TEST_CASE("every mode returns temperature and humidity in order", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    sensor_open(true);
+    for (shtc3_mode_t mode = 0; mode < SHTC3_MODE_MAX; mode++) {
+        TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, mode, &value));
+        TEST_ASSERT_EQUAL_HEX16(SIM_RAW_TEMP, value.temp);
+        TEST_ASSERT_EQUAL_HEX16(SIM_RAW_HUMIDITY, value.humidity);
+    }
+    sensor_close();
+}
+
+TEST_CASE("ready callback runs once per measurement", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    sensor_open(true);
+    atomic_store(&s_ready_calls, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_register_ready_cb(s_sensor, count_ready, NULL));
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, SHTC3_MODE_LP_T_FIRST, &value));
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, SHTC3_MODE_NORMAL_T_FIRST_STRETCH, &value));
+    TEST_ASSERT_EQUAL(2, atomic_load(&s_ready_calls));
+    sensor_close();
+}
+
+TEST_CASE("auto sleep wakes and sleeps the sensor around each measurement", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    // Command and read only
+    sensor_open(false);
+    uint32_t before = sim_transactions();
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, SHTC3_MODE_LP_T_FIRST, &value));
+    TEST_ASSERT_EQUAL_UINT32(2, sim_transactions() - before);
+    sensor_close();
+
+    // Plus wakeup before and sleep after
+    sensor_open(true);
+    before = sim_transactions();
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, SHTC3_MODE_LP_T_FIRST, &value));
+    TEST_ASSERT_EQUAL_UINT32(4, sim_transactions() - before);
+    sensor_close();
+}
+
+TEST_CASE("a failed read ends the measurement", "[shtc3]")
+{
+    shtc3_raw_value_t value;
+
+    sensor_open(false);
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_start_measurement(s_sensor, SHTC3_MODE_NORMAL_T_FIRST));
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_wait_ready(s_sensor, READY_TIMEOUT));
+
+    shtc3_sim_inject_nack(s_sim, 1);
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, shtc3_collect(s_sensor, &value));
+    TEST_ASSERT_EQUAL(SHTC3_STATE_IDLE, shtc3_get_state(s_sensor));
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, SHTC3_MODE_NORMAL_T_FIRST, &value));
+    sensor_close();
+}
+
+TEST_CASE("a measure that times out leaves the sensor ready for the next one", "[shtc3]")
+{
+    const esp_timer_create_args_t hold_args = {
+        .callback = hold_timer_task,
+        .name = "hold",
+    };
+    esp_timer_handle_t hold;
+    shtc3_raw_value_t value;
+
+    sensor_open(true);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_timer_create(&hold_args, &hold));
+
+    // The conversion timer can't fire while another callback blocks the timer task
+    TEST_ASSERT_EQUAL(ESP_OK, esp_timer_start_once(hold, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, shtc3_measure(s_sensor, SHTC3_MODE_NORMAL_T_FIRST, &value));
+    TEST_ASSERT_EQUAL(SHTC3_STATE_IDLE, shtc3_get_state(s_sensor));
+
+    // Nothing left over from the abandoned conversion once the timer task runs again
+    vTaskDelay(pdMS_TO_TICKS(TIMER_TASK_HOLD_MS + 20));
+    TEST_ASSERT_EQUAL(SHTC3_STATE_IDLE, shtc3_get_state(s_sensor));
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_measure(s_sensor, SHTC3_MODE_NORMAL_T_FIRST, &value));
+    TEST_ASSERT_EQUAL_HEX16(SIM_RAW_TEMP, value.temp);
+
+    esp_timer_delete(hold);
+    sensor_close();
+}
+
+TEST_CASE("a missing sensor is reported at create", "[shtc3]")
+{
+    const shtc3_config_t config = {
+        .dev_addr = SHTC3_I2C_ADDRESS + 1,
+        .auto_sleep = true,
+    };
+    shtc3_handle_t sensor = NULL;
+
+    TEST_ASSERT_EQUAL(ESP_OK, shtc3_sim_create(SIM_SCL_HZ, &s_sim));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, shtc3_create(s_sim, &config, &sensor));
+    TEST_ASSERT_NULL(sensor);
+    shtc3_sim_delete(s_sim);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
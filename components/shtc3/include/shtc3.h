@@ -0,0 +1,297 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include "shtc3_sim.h"
+#else
+#include "driver/i2c_master.h"
+#include "i2c_health.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHTC3_I2C_ADDRESS           0x70    /*!< Fixed I2C address of the SHTC3 */
+
+#define SHTC3_WAKEUP_TIME_US        240     /*!< Max time from wakeup command to idle state */
+#define SHTC3_MEAS_TIME_NORMAL_US   12100   /*!< Max conversion time, normal mode */
+#define SHTC3_MEAS_TIME_LP_US       800     /*!< Max conversion time, low-power mode */
+
+/* Scale factors for the fixed-point conversions */
+#define SHTC3_SCALE_UNIT            1       /*!< Whole degrees / percent */
+#define SHTC3_SCALE_DECI            10      /*!< Tenths */
+#define SHTC3_SCALE_CENTI           100     /*!< Hundredths */
+
+/* printf helpers for a fixed-point value at SHTC3_SCALE_CENTI, e.g. "-3.07" */
+#define SHTC3_CENTI_FMT             "%s%" PRIu32 ".%02" PRIu32
+#define SHTC3_CENTI_ARGS(v)         ((v) < 0 ? "-" : ""), \
+                                    (uint32_t)(((v) < 0 ? -(v) : (v)) / 100), \
+                                    (uint32_t)(((v) < 0 ? -(v) : (v)) % 100)
+
+#if CONFIG_IDF_TARGET_LINUX
+typedef shtc3_sim_handle_t shtc3_bus_handle_t;      /*!< Simulated bus on the host build */
+#else
+typedef i2c_master_bus_handle_t shtc3_bus_handle_t; /*!< I2C bus, from i2c_new_master_bus() */
+#endif
+
+typedef enum {
+    SHTC3_STATE_IDLE      = 0,  /*!< No conversion in progress */
+    SHTC3_STATE_MEASURING = 1,  /*!< Conversion started, result not available yet */
+    SHTC3_STATE_READY     = 2,  /*!< Conversion finished, waiting for shtc3_collect() */
+} shtc3_state_t;
+
+/*
+ * Measurement modes. Low-power mode converts in under 1 ms at reduced repeatability.
+ * With clock stretching the sensor holds SCL during the read until the result is ready;
+ * without it the driver waits out the conversion time and the bus stays free.
+ */
+typedef enum {
+    SHTC3_MODE_NORMAL_T_FIRST = 0,      /*!< Normal, T first, polling (0x7866) */
+    SHTC3_MODE_NORMAL_RH_FIRST,         /*!< Normal, RH first, polling (0x58E0) */
+    SHTC3_MODE_NORMAL_T_FIRST_STRETCH,  /*!< Normal, T first, clock stretching (0x7CA2) */
+    SHTC3_MODE_NORMAL_RH_FIRST_STRETCH, /*!< Normal, RH first, clock stretching (0x5C24) */
+    SHTC3_MODE_LP_T_FIRST,              /*!< Low power, T first, polling (0x609C) */
+    SHTC3_MODE_LP_RH_FIRST,             /*!< Low power, RH first, polling (0x401A) */
+    SHTC3_MODE_LP_T_FIRST_STRETCH,      /*!< Low power, T first, clock stretching (0x6458) */
+    SHTC3_MODE_LP_RH_FIRST_STRETCH,     /*!< Low power, RH first, clock stretching (0x44DE) */
+    SHTC3_MODE_MAX,
+} shtc3_mode_t;
+
+typedef struct {
+    uint8_t dev_addr;   /*!< I2C address, normally SHTC3_I2C_ADDRESS */
+    bool auto_sleep;    /*!< Put the sensor to sleep after every collected measurement */
+} shtc3_config_t;
+
+typedef struct {
+    uint16_t temp;      /*!< Raw temperature word */
+    uint16_t humidity;  /*!< Raw relative humidity word */
+} shtc3_raw_value_t;
+
+typedef void *shtc3_handle_t;
+
+/**
+ * @brief Measurement-ready callback
+ *
+ * Runs from the esp_timer task once the conversion time has elapsed.
+ * It must not block; typically it notifies the task that will call shtc3_collect().
+ *
+ * @param sensor   handle of the sensor that finished converting
+ * @param user_ctx context passed to shtc3_register_ready_cb()
+ */
+typedef void (*shtc3_ready_cb_t)(shtc3_handle_t sensor, void *user_ctx);
+
+/**
+ * @brief Create and init sensor object
+ *
+ * @param[in]  bus        bus the sensor is attached to
+ * @param[in]  config     sensor configuration
+ * @param[out] handle_ret handle to created SHTC3 driver object
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NO_MEM Not enough memory for the driver
+ *     - ESP_ERR_NOT_FOUND Sensor not found on the bus
+ *     - Others Error from underlying bus driver
+ */
+esp_err_t shtc3_create(shtc3_bus_handle_t bus, const shtc3_config_t *config, shtc3_handle_t *handle_ret);
+
+/**
+ * @brief Delete and release a sensor object
+ *
+ * @param sensor object handle of shtc3
+ */
+void shtc3_delete(shtc3_handle_t sensor);
+
+/**
+ * @brief Read the ID register of the SHTC3
+ *
+ * @param sensor object handle of shtc3
+ * @param id     a pointer to the ID word
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_CRC Checksum mismatch
+ *     - Others Error from underlying bus driver
+ */
+esp_err_t shtc3_get_id(shtc3_handle_t sensor, uint16_t *id);
+
+/**
+ * @brief Wake the sensor up from sleep
+ *
+ * @param sensor object handle of shtc3
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - Others Error from underlying bus driver
+ */
+esp_err_t shtc3_wakeup(shtc3_handle_t sensor);
+
+/**
+ * @brief Put the sensor to sleep
+ *
+ * @param sensor object handle of shtc3
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE A conversion is in progress
+ *     - Others Error from underlying bus driver
+ */
+esp_err_t shtc3_sleep(shtc3_handle_t sensor);
+
+/**
+ * @brief Register a callback invoked when a started measurement is ready
+ *
+ * @param sensor   object handle of shtc3
+ * @param cb       callback, NULL to unregister
+ * @param user_ctx context handed back to the callback
+ *
+ * @return
+ *     - ESP_OK Success
+ */
+esp_err_t shtc3_register_ready_cb(shtc3_handle_t sensor, shtc3_ready_cb_t cb, void *user_ctx);
+
+/**
+ * @brief Get the worst-case conversion time of a measurement mode
+ *
+ * @param mode measurement mode
+ *
+ * @return conversion time in microseconds
+ */
+uint32_t shtc3_get_meas_time_us(shtc3_mode_t mode);
+
+/**
+ * @brief Trigger a measurement and return immediately
+ *
+ * Wakes the sensor if needed and sends the measure command. In polling modes a
+ * one-shot timer is armed for the mode's conversion time and the bus is free
+ * while the sensor converts. In clock-stretching modes the measurement is
+ * reported ready at once (the ready callback runs in the calling task) and
+ * shtc3_collect() is held on the bus until the conversion ends.
+ *
+ * @param sensor object handle of shtc3
+ * @param mode   measurement mode
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Unknown mode
+ *     - ESP_ERR_INVALID_STATE A measurement is already pending
+ *     - Others Error from underlying bus driver
+ */
+esp_err_t shtc3_start_measurement(shtc3_handle_t sensor, shtc3_mode_t mode);
+
+/**
+ * @brief Get the measurement state
+ *
+ * @param sensor object handle of shtc3
+ *
+ * @return current state
+ */
+shtc3_state_t shtc3_get_state(shtc3_handle_t sensor);
+
+/**
+ * @brief Block until the pending measurement is ready
+ *
+ * @param sensor  object handle of shtc3
+ * @param timeout maximum time to wait, in ticks
+ *
+ * @return
+ *     - ESP_OK Measurement ready
+ *     - ESP_ERR_INVALID_STATE No measurement was started
+ *     - ESP_ERR_TIMEOUT Timed out
+ */
+esp_err_t shtc3_wait_ready(shtc3_handle_t sensor, TickType_t timeout);
+
+/**
+ * @brief Read back a finished measurement
+ *
+ * @param sensor object handle of shtc3
+ * @param value  raw measurements
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FINISHED Conversion still in progress
+ *     - ESP_ERR_INVALID_STATE No measurement was started
+ *     - ESP_ERR_INVALID_CRC Checksum mismatch
+ *     - Others Error from underlying bus driver
+ */
+esp_err_t shtc3_collect(shtc3_handle_t sensor, shtc3_raw_value_t *value);
+
+/**
+ * @brief Start, wait for and collect one measurement
+ *
+ * If the result isn't ready in time the measurement is dropped, so the
+ * driver is idle again and the next call can start a fresh one.
+ *
+ * @param sensor object handle of shtc3
+ * @param mode   measurement mode
+ * @param value  raw measurements
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_TIMEOUT Conversion timer late, measurement dropped
+ *     - Others see shtc3_start_measurement() and shtc3_collect()
+ */
+esp_err_t shtc3_measure(shtc3_handle_t sensor, shtc3_mode_t mode, shtc3_raw_value_t *value);
+
+#if !CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Get the retry and latency counters of the sensor's I2C device
+ *
+ * @param sensor object handle of shtc3
+ * @param stats  copy of the counters
+ */
+void shtc3_get_bus_stats(shtc3_handle_t sensor, i2c_health_stats_t *stats);
+#endif
+
+/**
+ * @brief Convert a raw temperature word to fixed-point degrees Celsius
+ *
+ * Integer-only; the result is the exact datasheet value rounded to the nearest step,
+ * which is what printf("%.*f") shows for the floating-point formula.
+ *
+ * @param raw   raw temperature word
+ * @param scale SHTC3_SCALE_UNIT, SHTC3_SCALE_DECI or SHTC3_SCALE_CENTI
+ *
+ * @return temperature * scale, e.g. 2345 for 23.45 C at SHTC3_SCALE_CENTI
+ */
+int32_t shtc3_temp_c_fixed(uint16_t raw, uint32_t scale);
+
+/**
+ * @brief Convert a raw temperature word to fixed-point degrees Fahrenheit
+ *
+ * @param raw   raw temperature word
+ * @param scale SHTC3_SCALE_UNIT, SHTC3_SCALE_DECI or SHTC3_SCALE_CENTI
+ *
+ * @return temperature * scale
+ */
+int32_t shtc3_temp_f_fixed(uint16_t raw, uint32_t scale);
+
+/**
+ * @brief Convert a raw humidity word to fixed-point percent relative humidity
+ *
+ * @param raw   raw humidity word
+ * @param scale SHTC3_SCALE_UNIT, SHTC3_SCALE_DECI or SHTC3_SCALE_CENTI
+ *
+ * @return humidity * scale
+ */
+int32_t shtc3_humidity_fixed(uint16_t raw, uint32_t scale);
+
+/**
+ * @brief Convert a raw temperature word to degrees Celsius
+ */
+float shtc3_raw_to_temp_c(uint16_t raw);
+
+/**
+ * @brief Convert a raw humidity word to percent relative humidity
+ */
+float shtc3_raw_to_humidity(uint16_t raw);
+
+#ifdef __cplusplus
+}
+#endif
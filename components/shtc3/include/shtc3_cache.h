@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "shtc3.h"
+#include "shtc3_sampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Read-through cache for slowly changing readings. shtc3_cache_get() never
+ * touches the bus: it returns the last measurement and, once that is older
+ * than the TTL, asks a background task to take a new one. The sensor is only
+ * measured while somebody is reading, and at most once per TTL.
+ */
+
+typedef struct {
+    shtc3_mode_t mode;          /*!< Measurement mode used for refreshes */
+    uint32_t ttl_ms;            /*!< Age after which a read triggers a refresh */
+    UBaseType_t task_priority;  /*!< Refresh task priority */
+    uint32_t task_stack;        /*!< Refresh task stack size in bytes */
+} shtc3_cache_config_t;
+
+#define SHTC3_CACHE_CONFIG_DEFAULT() {      \
+    .mode = SHTC3_MODE_NORMAL_T_FIRST,      \
+    .ttl_ms = 30000,                        \
+    .task_priority = 4,                     \
+    .task_stack = 3072,                     \
+}
+
+typedef void *shtc3_cache_handle_t;
+
+/**
+ * @brief Create a cache and start its refresh task
+ *
+ * The first measurement is requested right away. The cache takes over the
+ * sensor: nothing else may call into it until the cache is deleted.
+ *
+ * @param[in]  sensor     handle of an SHTC3 created with shtc3_create()
+ * @param[in]  config     cache configuration
+ * @param[out] handle_ret handle to the created cache
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Bad configuration
+ *     - ESP_ERR_NO_MEM Not enough memory for the cache or the task
+ */
+esp_err_t shtc3_cache_create(shtc3_handle_t sensor, const shtc3_cache_config_t *config,
+                             shtc3_cache_handle_t *handle_ret);
+
+/**
+ * @brief Stop the refresh task and release the cache
+ *
+ * @param cache object handle of the cache
+ */
+void shtc3_cache_delete(shtc3_cache_handle_t cache);
+
+/**
+ * @brief Get the cached measurement without blocking
+ *
+ * A value older than the TTL is still returned; check sample->timestamp_us if
+ * the age matters. Reading it schedules a refresh.
+ *
+ * @param cache  object handle of the cache
+ * @param sample copy of the cached measurement, fixed-point at SHTC3_SCALE_CENTI
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND No measurement has succeeded yet
+ */
+esp_err_t shtc3_cache_get(shtc3_cache_handle_t cache, shtc3_sample_t *sample);
+
+/**
+ * @brief Block until the cache holds a measurement
+ *
+ * @param cache   object handle of the cache
+ * @param timeout maximum time to wait, in ticks
+ *
+ * @return
+ *     - ESP_OK A measurement is available
+ *     - ESP_ERR_TIMEOUT Timed out
+ */
+esp_err_t shtc3_cache_wait_valid(shtc3_cache_handle_t cache, TickType_t timeout);
+
+/**
+ * @brief Get refresh counters
+ *
+ * @param cache    object handle of the cache
+ * @param refreshes successful refreshes since creation, may be NULL
+ * @param errors    failed refreshes since creation, may be NULL
+ */
+void shtc3_cache_get_counters(shtc3_cache_handle_t cache, uint32_t *refreshes, uint32_t *errors);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sensirion CRC-8: polynomial 0x31 (x^8 + x^5 + x^4 + 1), init 0xFF,
+ * no reflection, no final XOR. Every 16-bit word the SHTC3 sends is
+ * followed by this checksum.
+ *
+ * The lookup table is generated at compile time. A 256-entry table is used
+ * by default; CONFIG_SHTC3_CRC_NIBBLE_TABLE switches to a 16-entry table that
+ * processes four bits per step for flash-constrained builds.
+ */
+
+#define SHTC3_CRC_WORD_SIZE 3   /*!< Bytes per checksummed word on the wire: MSB, LSB, CRC */
+
+/**
+ * @brief Compute the CRC-8 of a buffer
+ *
+ * @param data bytes to checksum
+ * @param len  number of bytes
+ *
+ * @return checksum
+ */
+uint8_t shtc3_crc8(const uint8_t *data, size_t len);
+
+/**
+ * @brief Verify and unpack every word of a multi-word frame in one call
+ *
+ * All words are checked even when an early one fails, so the cost does not
+ * depend on the data.
+ *
+ * @param frame      raw frame, SHTC3_CRC_WORD_SIZE bytes per word
+ * @param word_count number of words in the frame
+ * @param words      unpacked words, or NULL to only verify
+ *
+ * @return
+ *     - ESP_OK All checksums match
+ *     - ESP_ERR_INVALID_CRC At least one checksum does not match
+ */
+esp_err_t shtc3_crc_unpack(const uint8_t *frame, size_t word_count, uint16_t *words);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "shtc3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Background sampler: one task owns the sensor and measures it at a fixed
+ * period into a ring buffer. Readers copy the latest sample, the history or
+ * the window aggregates without touching the bus, and never block the
+ * producer: snapshots are taken under a sequence counter and retried if the
+ * producer published in the meantime.
+ *
+ * All values are fixed-point at SHTC3_SCALE_CENTI.
+ */
+
+#define SHTC3_SAMPLER_MAX_EWMA_SHIFT    8
+
+typedef struct {
+    shtc3_mode_t mode;          /*!< Measurement mode used by the producer */
+    uint32_t period_ms;         /*!< Sampling period */
+    uint16_t window;            /*!< Samples kept for history and min/max/mean */
+    uint8_t ewma_shift;         /*!< EWMA weight of a new sample is 1 / 2^ewma_shift */
+    UBaseType_t task_priority;  /*!< Producer task priority */
+    uint32_t task_stack;        /*!< Producer task stack size in bytes */
+} shtc3_sampler_config_t;
+
+#define SHTC3_SAMPLER_CONFIG_DEFAULT() {    \
+    .mode = SHTC3_MODE_NORMAL_T_FIRST,      \
+    .period_ms = 1000,                      \
+    .window = 16,                           \
+    .ewma_shift = 3,                        \
+    .task_priority = 5,                     \
+    .task_stack = 3072,                     \
+}
+
+typedef struct {
+    int64_t timestamp_us;       /*!< esp_timer time the measurement was collected */
+    int32_t temp_c;             /*!< Temperature, hundredths of a degree Celsius */
+    int32_t humidity;           /*!< Relative humidity, hundredths of a percent */
+} shtc3_sample_t;
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t mean;               /*!< Mean over the window, rounded toward zero */
+    int32_t ewma;               /*!< Exponentially weighted moving average over all samples */
+} shtc3_sampler_agg_t;
+
+typedef struct {
+    uint32_t samples;           /*!< Successful measurements since creation */
+    uint32_t errors;            /*!< Failed measurements since creation */
+    uint16_t count;             /*!< Samples currently in the window */
+    shtc3_sample_t latest;      /*!< Most recent sample */
+    shtc3_sampler_agg_t temp_c;
+    shtc3_sampler_agg_t humidity;
+} shtc3_sampler_stats_t;
+
+typedef void *shtc3_sampler_handle_t;
+
+/**
+ * @brief Create a sampler and start its producer task
+ *
+ * The sampler takes over the sensor: nothing else may call into it until the
+ * sampler is deleted.
+ *
+ * @param[in]  sensor     handle of an SHTC3 created with shtc3_create()
+ * @param[in]  config     sampler configuration
+ * @param[out] handle_ret handle to the created sampler
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Bad configuration
+ *     - ESP_ERR_NO_MEM Not enough memory for the ring or the task
+ */
+esp_err_t shtc3_sampler_create(shtc3_handle_t sensor, const shtc3_sampler_config_t *config,
+                               shtc3_sampler_handle_t *handle_ret);
+
+/**
+ * @brief Stop the producer task and release the sampler
+ *
+ * Returns once the task has finished its current measurement.
+ *
+ * @param sampler object handle of the sampler
+ */
+void shtc3_sampler_delete(shtc3_sampler_handle_t sampler);
+
+/**
+ * @brief Get the most recent sample
+ *
+ * @param sampler object handle of the sampler
+ * @param sample  copy of the sample
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND No sample taken yet
+ */
+esp_err_t shtc3_sampler_get_latest(shtc3_sampler_handle_t sampler, shtc3_sample_t *sample);
+
+/**
+ * @brief Get counters and the window aggregates
+ *
+ * @param sampler object handle of the sampler
+ * @param stats   copy of the statistics
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND No sample taken yet
+ */
+esp_err_t shtc3_sampler_get_stats(shtc3_sampler_handle_t sampler, shtc3_sampler_stats_t *stats);
+
+/**
+ * @brief Copy the samples in the window, newest first
+ *
+ * @param sampler   object handle of the sampler
+ * @param samples   destination array
+ * @param max_count capacity of the destination array
+ *
+ * @return number of samples copied
+ */
+size_t shtc3_sampler_get_history(shtc3_sampler_handle_t sampler, shtc3_sample_t *samples, size_t max_count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Simulated SHTC3 on a simulated I2C bus, used by the linux target build.
+ * It follows the datasheet state machine (sleep, idle, converting) and NACKs
+ * reads that arrive before the conversion time has elapsed.
+ */
+
+typedef struct {
+    uint32_t transactions;  /*!< Write and read transfers addressed to the sensor */
+    uint32_t bytes_written; /*!< Payload bytes written */
+    uint32_t bytes_read;    /*!< Payload bytes read */
+    uint32_t nacks;         /*!< Transfers the sensor did not acknowledge */
+    uint64_t bus_time_us;   /*!< Modelled bus time at the configured SCL rate */
+} shtc3_sim_stats_t;
+
+typedef struct shtc3_sim_t *shtc3_sim_handle_t;
+
+/**
+ * @brief Create a simulated bus with one SHTC3 attached
+ *
+ * @param[in]  scl_speed_hz SCL rate used to model bus time
+ * @param[out] sim_ret      handle to the simulated bus
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t shtc3_sim_create(uint32_t scl_speed_hz, shtc3_sim_handle_t *sim_ret);
+
+/**
+ * @brief Delete a simulated bus
+ */
+void shtc3_sim_delete(shtc3_sim_handle_t sim);
+
+/**
+ * @brief Set the raw words the simulated sensor will report
+ */
+void shtc3_sim_set_raw(shtc3_sim_handle_t sim, uint16_t temp, uint16_t humidity);
+
+/**
+ * @brief Make the next @p count transfers fail with a NACK
+ */
+void shtc3_sim_inject_nack(shtc3_sim_handle_t sim, uint32_t count);
+
+/**
+ * @brief Get the bus statistics accumulated so far
+ */
+void shtc3_sim_get_stats(shtc3_sim_handle_t sim, shtc3_sim_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "shtc3.h"
+
+/*
+ * Bus glue between the SHTC3 state machine and the transport it runs on.
+ * shtc3_port_i2c.c talks to the I2C master driver, shtc3_port_sim.c to the
+ * simulated sensor used by the linux target build.
+ */
+
+typedef void *shtc3_port_dev_t;
+
+esp_err_t shtc3_port_add_device(shtc3_bus_handle_t bus, uint8_t dev_addr, shtc3_port_dev_t *dev_ret);
+void shtc3_port_rm_device(shtc3_port_dev_t dev);
+esp_err_t shtc3_port_write(shtc3_port_dev_t dev, const uint8_t *data, size_t len);
+esp_err_t shtc3_port_read(shtc3_port_dev_t dev, uint8_t *data, size_t len);
+void shtc3_port_delay_us(uint32_t us);
@@ -0,0 +1,38 @@
+#include "driver/i2c_master.h"
+#include "esp_rom_sys.h"
+#include "i2c_health.h"
+#include "shtc3_port.h"
+
+#define SHTC3_I2C_CLK_SPEED     100000
+#define SHTC3_I2C_TIMEOUT_MS    50
+#define SHTC3_SCL_WAIT_US       (SHTC3_MEAS_TIME_NORMAL_US + 2000)  /* Clock-stretching modes hold SCL for a whole conversion */
+
+esp_err_t shtc3_port_add_device(shtc3_bus_handle_t bus, uint8_t dev_addr, shtc3_port_dev_t *dev_ret)
+{
+    const i2c_device_config_t i2c_dev_cfg = {
+        .device_address = dev_addr,
+        .scl_speed_hz = SHTC3_I2C_CLK_SPEED,
+        .scl_wait_us = SHTC3_SCL_WAIT_US,
+    };
+    return i2c_health_add_device(bus, &i2c_dev_cfg, NULL, (i2c_health_dev_handle_t *) dev_ret);
+}
+
+void shtc3_port_rm_device(shtc3_port_dev_t dev)
+{
+    i2c_health_rm_device(dev);
+}
+
+esp_err_t shtc3_port_write(shtc3_port_dev_t dev, const uint8_t *data, size_t len)
+{
+    return i2c_health_transmit(dev, data, len, SHTC3_I2C_TIMEOUT_MS);
+}
+
+esp_err_t shtc3_port_read(shtc3_port_dev_t dev, uint8_t *data, size_t len)
+{
+    return i2c_health_receive(dev, data, len, SHTC3_I2C_TIMEOUT_MS);
+}
+
+void shtc3_port_delay_us(uint32_t us)
+{
+    esp_rom_delay_us(us);
+}
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "shtc3_crc.h"
+#include "shtc3_port.h"
+#include "shtc3_sim.h"
+
+#define SIM_CMD_WAKEUP      0x3517
+#define SIM_CMD_SLEEP       0xB098
+#define SIM_CMD_READ_ID     0xEFC8
+
+#define SIM_ID              0x0887
+#define SIM_BITS_PER_BYTE   9   /* 8 data bits + ACK */
+#define SIM_BITS_OVERHEAD   2   /* START + STOP */
+
+typedef struct {
+    uint16_t cmd;
+    bool rh_first;
+    bool stretch;
+    uint32_t meas_time_us;
+} sim_meas_cmd_t;
+
+static const sim_meas_cmd_t s_meas_cmds[] = {
+    { 0x7866, false, false, SHTC3_MEAS_TIME_NORMAL_US },
+    { 0x58E0, true,  false, SHTC3_MEAS_TIME_NORMAL_US },
+    { 0x7CA2, false, true,  SHTC3_MEAS_TIME_NORMAL_US },
+    { 0x5C24, true,  true,  SHTC3_MEAS_TIME_NORMAL_US },
+    { 0x609C, false, false, SHTC3_MEAS_TIME_LP_US },
+    { 0x401A, true,  false, SHTC3_MEAS_TIME_LP_US },
+    { 0x6458, false, true,  SHTC3_MEAS_TIME_LP_US },
+    { 0x44DE, true,  true,  SHTC3_MEAS_TIME_LP_US },
+};
+
+typedef enum {
+    SIM_REPLY_NONE,
+    SIM_REPLY_ID,
+    SIM_REPLY_MEASUREMENT,
+} sim_reply_t;
+
+struct shtc3_sim_t {
+    uint8_t dev_addr;
+    uint32_t scl_speed_hz;
+    bool asleep;
+    sim_reply_t reply;
+    int64_t ready_at_us;
+    const sim_meas_cmd_t *meas;
+    uint16_t raw_temp;
+    uint16_t raw_humidity;
+    uint32_t nacks_pending;
+    shtc3_sim_stats_t stats;
+};
+
+static void sim_account(struct shtc3_sim_t *sim, size_t len, bool acked)
+{
+    sim->stats.transactions++;
+    sim->stats.bus_time_us += ((1 + (acked ? len : 0)) * SIM_BITS_PER_BYTE + SIM_BITS_OVERHEAD) * 1000000ULL / sim->scl_speed_hz;
+    if (!acked) {
+        sim->stats.nacks++;
+    }
+}
+
+static bool sim_nack_injected(struct shtc3_sim_t *sim)
+{
+    if (sim->nacks_pending == 0) {
+        return false;
+    }
+    sim->nacks_pending--;
+    return true;
+}
+
+static void sim_put_word(uint8_t *out, uint16_t word)
+{
+    out[0] = word >> 8;
+    out[1] = word & 0xFF;
+    out[2] = shtc3_crc8(out, 2);
+}
+
+esp_err_t shtc3_sim_create(uint32_t scl_speed_hz, shtc3_sim_handle_t *sim_ret)
+{
+    struct shtc3_sim_t *sim = calloc(1, sizeof(struct shtc3_sim_t));
+    if (sim == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    sim->dev_addr = SHTC3_I2C_ADDRESS;
+    sim->scl_speed_hz = scl_speed_hz;
+    sim->raw_temp = 0x6666;      /* 25 C */
+    sim->raw_humidity = 0x8000;  /* 50 %RH */
+    *sim_ret = sim;
+    return ESP_OK;
+}
+
+void shtc3_sim_delete(shtc3_sim_handle_t sim)
+{
+    free(sim);
+}
+
+void shtc3_sim_set_raw(shtc3_sim_handle_t sim, uint16_t temp, uint16_t humidity)
+{
+    sim->raw_temp = temp;
+    sim->raw_humidity = humidity;
+}
+
+void shtc3_sim_inject_nack(shtc3_sim_handle_t sim, uint32_t count)
+{
+    sim->nacks_pending = count;
+}
+
+void shtc3_sim_get_stats(shtc3_sim_handle_t sim, shtc3_sim_stats_t *stats)
+{
+    *stats = sim->stats;
+}
+
+esp_err_t shtc3_port_add_device(shtc3_bus_handle_t bus, uint8_t dev_addr, shtc3_port_dev_t *dev_ret)
+{
+    if (dev_addr != bus->dev_addr) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *dev_ret = bus;
+    return ESP_OK;
+}
+
+void shtc3_port_rm_device(shtc3_port_dev_t dev)
+{
+    (void) dev;
+}
+
+esp_err_t shtc3_port_write(shtc3_port_dev_t dev, const uint8_t *data, size_t len)
+{
+    struct shtc3_sim_t *sim = dev;
+    uint16_t cmd = (len == 2) ? (uint16_t)((data[0] << 8) | data[1]) : 0;
+
+    /* A sleeping sensor only acknowledges the wakeup command */
+    bool acked = !sim_nack_injected(sim) && len == 2 && (!sim->asleep || cmd == SIM_CMD_WAKEUP);
+    sim_account(sim, len, acked);
+    if (!acked) {
+        return ESP_FAIL;
+    }
+    sim->stats.bytes_written += len;
+
+    switch (cmd) {
+    case SIM_CMD_WAKEUP:
+        sim->asleep = false;
+        break;
+    case SIM_CMD_SLEEP:
+        sim->asleep = true;
+        sim->reply = SIM_REPLY_NONE;
+        break;
+    case SIM_CMD_READ_ID:
+        sim->reply = SIM_REPLY_ID;
+        break;
+    default:
+        sim->reply = SIM_REPLY_NONE;
+        for (size_t i = 0; i < sizeof(s_meas_cmds) / sizeof(s_meas_cmds[0]); i++) {
+            if (s_meas_cmds[i].cmd == cmd) {
+                sim->meas = &s_meas_cmds[i];
+                sim->reply = SIM_REPLY_MEASUREMENT;
+                sim->ready_at_us = esp_timer_get_time() + sim->meas->meas_time_us;
+                break;
+            }
+        }
+        break;
+    }
+    return ESP_OK;
+}
+
+esp_err_t shtc3_port_read(shtc3_port_dev_t dev, uint8_t *data, size_t len)
+{
+    struct shtc3_sim_t *sim = dev;
+
+    bool acked = !sim_nack_injected(sim) && !sim->asleep && sim->reply != SIM_REPLY_NONE;
+    if (acked && sim->reply == SIM_REPLY_MEASUREMENT) {
+        int64_t remaining_us = sim->ready_at_us - esp_timer_get_time();
+        if (remaining_us > 0 && sim->meas->stretch) {
+            /* Clock stretching: the bus is held until the conversion ends */
+            usleep(remaining_us);
+            sim->stats.bus_time_us += remaining_us;
+        } else if (remaining_us > 0) {
+            acked = false;  /* still converting */
+        }
+    }
+    sim_account(sim, len, acked);
+    if (!acked) {
+        return ESP_FAIL;
+    }
+
+    uint8_t frame[6];
+    size_t frame_len = 3;
+    if (sim->reply == SIM_REPLY_ID) {
+        sim_put_word(frame, SIM_ID);
+    } else {
+        sim_put_word(&frame[sim->meas->rh_first ? 3 : 0], sim->raw_temp);
+        sim_put_word(&frame[sim->meas->rh_first ? 0 : 3], sim->raw_humidity);
+        frame_len = 6;
+    }
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (i < frame_len) ? frame[i] : 0xFF;
+    }
+    sim->stats.bytes_read += len;
+    sim->reply = SIM_REPLY_NONE;
+    return ESP_OK;
+}
+
+void shtc3_port_delay_us(uint32_t us)
+{
+    usleep(us);
+}
@@ -0,0 +1,402 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "shtc3.h"
+#include "shtc3_crc.h"
+#include "shtc3_port.h"
+
+/* SHTC3 commands */
+#define SHTC3_CMD_WAKEUP        0x3517
+#define SHTC3_CMD_SLEEP         0xB098
+#define SHTC3_CMD_READ_ID       0xEFC8
+
+typedef struct {
+    uint16_t cmd;
+    bool rh_first;
+    bool stretch;
+    uint32_t meas_time_us;
+} shtc3_mode_info_t;
+
+static const shtc3_mode_info_t s_modes[SHTC3_MODE_MAX] = {
+    [SHTC3_MODE_NORMAL_T_FIRST]          = { 0x7866, false, false, SHTC3_MEAS_TIME_NORMAL_US },
+    [SHTC3_MODE_NORMAL_RH_FIRST]         = { 0x58E0, true,  false, SHTC3_MEAS_TIME_NORMAL_US },
+    [SHTC3_MODE_NORMAL_T_FIRST_STRETCH]  = { 0x7CA2, false, true,  SHTC3_MEAS_TIME_NORMAL_US },
+    [SHTC3_MODE_NORMAL_RH_FIRST_STRETCH] = { 0x5C24, true,  true,  SHTC3_MEAS_TIME_NORMAL_US },
+    [SHTC3_MODE_LP_T_FIRST]              = { 0x609C, false, false, SHTC3_MEAS_TIME_LP_US },
+    [SHTC3_MODE_LP_RH_FIRST]             = { 0x401A, true,  false, SHTC3_MEAS_TIME_LP_US },
+    [SHTC3_MODE_LP_T_FIRST_STRETCH]      = { 0x6458, false, true,  SHTC3_MEAS_TIME_LP_US },
+    [SHTC3_MODE_LP_RH_FIRST_STRETCH]     = { 0x44DE, true,  true,  SHTC3_MEAS_TIME_LP_US },
+};
+
+/*
+ * Datasheet conversions: T = -45 + 175 * raw / 65535 C, T = -49 + 315 * raw / 65535 F,
+ * RH = 100 * raw / 65535 %. The offsets are integers, so only the span term needs rounding.
+ */
+#define SHTC3_RAW_FULL_SCALE    65535U
+#define SHTC3_TEMP_C_OFFSET     (-45)
+#define SHTC3_TEMP_C_SPAN       175U
+#define SHTC3_TEMP_F_OFFSET     (-49)
+#define SHTC3_TEMP_F_SPAN       315U
+#define SHTC3_RH_SPAN           100U
+
+/* ID register: bit 11 set and bits 5..0 = 0b000111 identify an SHTC3 */
+#define SHTC3_ID_MASK           0x083F
+#define SHTC3_ID_VALUE          0x0807
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef struct {
+    shtc3_port_dev_t dev;
+    esp_timer_handle_t timer;       /*!< Fires when the conversion time has elapsed */
+    SemaphoreHandle_t ready_sem;    /*!< Given by the timer, taken by shtc3_wait_ready() */
+    shtc3_ready_cb_t ready_cb;
+    void *ready_cb_ctx;
+    atomic_int state;               /*!< shtc3_state_t, written from the timer task too */
+    shtc3_mode_t mode;              /*!< Mode of the pending measurement */
+    bool asleep;
+    bool auto_sleep;
+} shtc3_dev_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static esp_err_t shtc3_write_cmd(shtc3_dev_t *sens, uint16_t cmd);
+static esp_err_t shtc3_read_words(shtc3_dev_t *sens, uint16_t *words, size_t count);
+static void shtc3_timer_cb(void *arg);
+static bool shtc3_abandon(shtc3_dev_t *sens);
+static uint32_t shtc3_scale_span(uint16_t raw, uint32_t span);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "SHTC3";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t shtc3_create(shtc3_bus_handle_t bus, const shtc3_config_t *config, shtc3_handle_t *handle_ret)
+{
+    esp_err_t ret = ESP_OK;
+
+    assert(config != NULL && handle_ret != NULL);
+
+    shtc3_dev_t *sensor = (shtc3_dev_t *) calloc(1, sizeof(shtc3_dev_t));
+    ESP_RETURN_ON_FALSE(sensor != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+    atomic_init(&sensor->state, SHTC3_STATE_IDLE);
+    sensor->auto_sleep = config->auto_sleep;
+
+    sensor->ready_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(sensor->ready_sem != NULL, ESP_ERR_NO_MEM, err, TAG, "Not enough memory");
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = shtc3_timer_cb,
+        .arg = sensor,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "shtc3",
+    };
+    ESP_GOTO_ON_ERROR(esp_timer_create(&timer_args, &sensor->timer), err, TAG, "Failed to create timer");
+
+    ESP_GOTO_ON_ERROR(shtc3_port_add_device(bus, config->dev_addr, &sensor->dev), err, TAG, "Failed to add new I2C device");
+
+    // The sensor may have been left asleep by a previous run
+    ESP_GOTO_ON_ERROR(shtc3_wakeup(sensor), err, TAG, "Wakeup failed");
+
+    // Check device presence
+    uint16_t id = 0;
+    ESP_GOTO_ON_ERROR(shtc3_get_id(sensor, &id), err, TAG, "Failed to read ID");
+    ESP_GOTO_ON_FALSE((id & SHTC3_ID_MASK) == SHTC3_ID_VALUE, ESP_ERR_NOT_FOUND, err, TAG, "Incorrect Device ID (0x%04x).", id);
+    ESP_LOGD(TAG, "Found SHTC3, ID: 0x%04x", id);
+
+    if (sensor->auto_sleep) {
+        ESP_GOTO_ON_ERROR(shtc3_sleep(sensor), err, TAG, "Sleep failed");
+    }
+
+    *handle_ret = sensor;
+    return ret;
+
+err:
+    shtc3_delete(sensor);
+    return ret;
+}
+
+void shtc3_delete(shtc3_handle_t sensor)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    if (sens->timer) {
+        esp_timer_stop(sens->timer);
+        esp_timer_delete(sens->timer);
+    }
+
+    if (sens->dev) {
+        shtc3_port_rm_device(sens->dev);
+    }
+
+    if (sens->ready_sem) {
+        vSemaphoreDelete(sens->ready_sem);
+    }
+
+    free(sens);
+}
+
+esp_err_t shtc3_get_id(shtc3_handle_t sensor, uint16_t *id)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    assert(id != NULL);
+
+    ESP_RETURN_ON_ERROR(shtc3_write_cmd(sens, SHTC3_CMD_READ_ID), TAG, "Read ID command failed");
+    return shtc3_read_words(sens, id, 1);
+}
+
+esp_err_t shtc3_wakeup(shtc3_handle_t sensor)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    esp_err_t ret = shtc3_write_cmd(sens, SHTC3_CMD_WAKEUP);
+    if (ret == ESP_OK) {
+        shtc3_port_delay_us(SHTC3_WAKEUP_TIME_US);
+        sens->asleep = false;
+    }
+    return ret;
+}
+
+esp_err_t shtc3_sleep(shtc3_handle_t sensor)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    ESP_RETURN_ON_FALSE(atomic_load(&sens->state) != SHTC3_STATE_MEASURING, ESP_ERR_INVALID_STATE, TAG, "Conversion in progress");
+
+    esp_err_t ret = shtc3_write_cmd(sens, SHTC3_CMD_SLEEP);
+    if (ret == ESP_OK) {
+        sens->asleep = true;
+    }
+    return ret;
+}
+
+esp_err_t shtc3_register_ready_cb(shtc3_handle_t sensor, shtc3_ready_cb_t cb, void *user_ctx)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    sens->ready_cb = cb;
+    sens->ready_cb_ctx = user_ctx;
+    return ESP_OK;
+}
+
+uint32_t shtc3_get_meas_time_us(shtc3_mode_t mode)
+{
+    assert(mode < SHTC3_MODE_MAX);
+
+    return s_modes[mode].meas_time_us;
+}
+
+esp_err_t shtc3_start_measurement(shtc3_handle_t sensor, shtc3_mode_t mode)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    ESP_RETURN_ON_FALSE(mode < SHTC3_MODE_MAX, ESP_ERR_INVALID_ARG, TAG, "Invalid mode");
+    ESP_RETURN_ON_FALSE(atomic_load(&sens->state) == SHTC3_STATE_IDLE, ESP_ERR_INVALID_STATE, TAG, "Measurement already pending");
+
+    if (sens->asleep) {
+        ESP_RETURN_ON_ERROR(shtc3_wakeup(sens), TAG, "Wakeup failed");
+    }
+
+    // Drop a stale notification from a measurement that was never waited on
+    xSemaphoreTake(sens->ready_sem, 0);
+
+    const shtc3_mode_info_t *info = &s_modes[mode];
+    ESP_RETURN_ON_ERROR(shtc3_write_cmd(sens, info->cmd), TAG, "Measure command failed");
+    sens->mode = mode;
+
+    atomic_store(&sens->state, SHTC3_STATE_MEASURING);
+    if (info->stretch) {
+        // The sensor holds SCL during the read, so the result can be collected right away
+        shtc3_timer_cb(sens);
+        return ESP_OK;
+    }
+
+    esp_err_t ret = esp_timer_start_once(sens->timer, info->meas_time_us);
+    if (ret != ESP_OK) {
+        atomic_store(&sens->state, SHTC3_STATE_IDLE);
+    }
+    return ret;
+}
+
+shtc3_state_t shtc3_get_state(shtc3_handle_t sensor)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    return (shtc3_state_t) atomic_load(&sens->state);
+}
+
+esp_err_t shtc3_wait_ready(shtc3_handle_t sensor, TickType_t timeout)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    switch (atomic_load(&sens->state)) {
+    case SHTC3_STATE_READY:
+        return ESP_OK;
+    case SHTC3_STATE_IDLE:
+        return ESP_ERR_INVALID_STATE;
+    default:
+        break;
+    }
+
+    return (xSemaphoreTake(sens->ready_sem, timeout) == pdTRUE) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t shtc3_collect(shtc3_handle_t sensor, shtc3_raw_value_t *value)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+    uint16_t words[2];
+
+    assert(value != NULL);
+
+    switch (atomic_load(&sens->state)) {
+    case SHTC3_STATE_MEASURING:
+        return ESP_ERR_NOT_FINISHED;
+    case SHTC3_STATE_IDLE:
+        return ESP_ERR_INVALID_STATE;
+    default:
+        break;
+    }
+
+    // The result is consumed (or lost) by this read either way
+    esp_err_t ret = shtc3_read_words(sens, words, 2);
+    atomic_store(&sens->state, SHTC3_STATE_IDLE);
+
+    if (sens->auto_sleep) {
+        esp_err_t sleep_ret = shtc3_sleep(sens);
+        if (ret == ESP_OK) {
+            ret = sleep_ret;
+        }
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "Read measurement failed");
+
+    bool rh_first = s_modes[sens->mode].rh_first;
+    value->temp = words[rh_first ? 1 : 0];
+    value->humidity = words[rh_first ? 0 : 1];
+    return ESP_OK;
+}
+
+esp_err_t shtc3_measure(shtc3_handle_t sensor, shtc3_mode_t mode, shtc3_raw_value_t *value)
+{
+    ESP_RETURN_ON_ERROR(shtc3_start_measurement(sensor, mode), TAG, "Start measurement failed");
+
+    // Rounded up, plus one tick for the timer firing just after a tick boundary
+    TickType_t timeout = pdMS_TO_TICKS(shtc3_get_meas_time_us(mode) / 1000) + 2;
+    esp_err_t ret = shtc3_wait_ready(sensor, timeout);
+    if (ret == ESP_ERR_TIMEOUT && !shtc3_abandon((shtc3_dev_t *) sensor)) {
+        ret = ESP_OK;   // The timer fired just after the wait gave up
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return shtc3_collect(sensor, value);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+void shtc3_get_bus_stats(shtc3_handle_t sensor, i2c_health_stats_t *stats)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) sensor;
+
+    i2c_health_get_stats(sens->dev, stats);
+}
+#endif
+
+int32_t shtc3_temp_c_fixed(uint16_t raw, uint32_t scale)
+{
+    return SHTC3_TEMP_C_OFFSET * (int32_t) scale + (int32_t) shtc3_scale_span(raw, SHTC3_TEMP_C_SPAN * scale);
+}
+
+int32_t shtc3_temp_f_fixed(uint16_t raw, uint32_t scale)
+{
+    return SHTC3_TEMP_F_OFFSET * (int32_t) scale + (int32_t) shtc3_scale_span(raw, SHTC3_TEMP_F_SPAN * scale);
+}
+
+int32_t shtc3_humidity_fixed(uint16_t raw, uint32_t scale)
+{
+    return (int32_t) shtc3_scale_span(raw, SHTC3_RH_SPAN * scale);
+}
+
+float shtc3_raw_to_temp_c(uint16_t raw)
+{
+    return -45.0f + 175.0f * raw / 65535.0f;
+}
+
+float shtc3_raw_to_humidity(uint16_t raw)
+{
+    return 100.0f * raw / 65535.0f;
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static esp_err_t shtc3_write_cmd(shtc3_dev_t *sens, uint16_t cmd)
+{
+    uint8_t buf[2] = { (uint8_t)(cmd >> 8), (uint8_t)(cmd & 0xFF) };
+
+    return shtc3_port_write(sens->dev, buf, sizeof(buf));
+}
+
+static esp_err_t shtc3_read_words(shtc3_dev_t *sens, uint16_t *words, size_t count)
+{
+    uint8_t buf[2 * SHTC3_CRC_WORD_SIZE];
+
+    assert(count <= 2);
+
+    esp_err_t ret = shtc3_port_read(sens->dev, buf, count * SHTC3_CRC_WORD_SIZE);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return shtc3_crc_unpack(buf, count, words);
+}
+
+/*
+ * round(span * raw / 65535) in 32-bit integer arithmetic. 2 * span * raw is even and
+ * 65535 is odd, so the exact quotient is never halfway and round-half-up is exact.
+ * span <= 315 * 100 keeps 2 * span * 65535 + 65535 below 2^32.
+ */
+static uint32_t shtc3_scale_span(uint16_t raw, uint32_t span)
+{
+    assert(span <= SHTC3_TEMP_F_SPAN * SHTC3_SCALE_CENTI);
+
+    return (2U * span * raw + SHTC3_RAW_FULL_SCALE) / (2U * SHTC3_RAW_FULL_SCALE);
+}
+
+static void shtc3_timer_cb(void *arg)
+{
+    shtc3_dev_t *sens = (shtc3_dev_t *) arg;
+    int expected = SHTC3_STATE_MEASURING;
+
+    // Nothing to report if shtc3_measure() gave up on this conversion
+    if (!atomic_compare_exchange_strong(&sens->state, &expected, SHTC3_STATE_READY)) {
+        return;
+    }
+    if (sens->ready_cb) {
+        sens->ready_cb(sens, sens->ready_cb_ctx);
+    }
+    xSemaphoreGive(sens->ready_sem);
+}
+
+/*
+ * Drop a conversion whose timer is late, so the next start finds the driver
+ * idle. Returns false if the timer fired after all and the result is ready.
+ */
+static bool shtc3_abandon(shtc3_dev_t *sens)
+{
+    int expected = SHTC3_STATE_MEASURING;
+
+    esp_timer_stop(sens->timer);
+    return atomic_compare_exchange_strong(&sens->state, &expected, SHTC3_STATE_IDLE);
+}
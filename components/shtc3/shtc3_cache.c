@@ -0,0 +1,200 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "esp_bit_defs.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "shtc3_cache.h"
+#include "shtc3_seqlock.h"
+
+#define SHTC3_CACHE_VALID_BIT       BIT0
+#define SHTC3_CACHE_RETRY_MS        1000    /* Hold-off after a failed refresh */
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef struct {
+    shtc3_handle_t sensor;
+    shtc3_cache_config_t config;
+    TaskHandle_t task;
+    SemaphoreHandle_t done_sem;     /*!< Given by the task right before it exits */
+    EventGroupHandle_t events;      /*!< SHTC3_CACHE_VALID_BIT once a measurement succeeded */
+    atomic_bool stop;
+    atomic_bool refresh_pending;    /*!< Set by the reader that requested a refresh, cleared by the task */
+    atomic_uint refreshes;
+    atomic_uint errors;
+
+    /* Published state, guarded by seq */
+    atomic_uint seq;
+    bool valid;
+    shtc3_sample_t sample;
+} shtc3_cache_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static void shtc3_cache_task(void *arg);
+static void shtc3_cache_request_refresh(shtc3_cache_t *cache);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "SHTC3_CACHE";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t shtc3_cache_create(shtc3_handle_t sensor, const shtc3_cache_config_t *config,
+                             shtc3_cache_handle_t *handle_ret)
+{
+    esp_err_t ret = ESP_OK;
+
+    assert(sensor != NULL && config != NULL && handle_ret != NULL);
+    ESP_RETURN_ON_FALSE(config->mode < SHTC3_MODE_MAX, ESP_ERR_INVALID_ARG, TAG, "Invalid mode");
+
+    shtc3_cache_t *cache = (shtc3_cache_t *) calloc(1, sizeof(shtc3_cache_t));
+    ESP_RETURN_ON_FALSE(cache != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+    cache->sensor = sensor;
+    cache->config = *config;
+    atomic_init(&cache->stop, false);
+    atomic_init(&cache->refresh_pending, false);
+    atomic_init(&cache->refreshes, 0);
+    atomic_init(&cache->errors, 0);
+    atomic_init(&cache->seq, 0);
+
+    cache->done_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(cache->done_sem != NULL, ESP_ERR_NO_MEM, err, TAG, "Not enough memory");
+    cache->events = xEventGroupCreate();
+    ESP_GOTO_ON_FALSE(cache->events != NULL, ESP_ERR_NO_MEM, err, TAG, "Not enough memory");
+
+    BaseType_t res = xTaskCreate(shtc3_cache_task, "shtc3_cache", config->task_stack, cache,
+                                 config->task_priority, &cache->task);
+    ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "Failed to create task");
+
+    // Fill the cache before the first reader asks
+    shtc3_cache_request_refresh(cache);
+
+    *handle_ret = cache;
+    return ret;
+
+err:
+    if (cache->events) {
+        vEventGroupDelete(cache->events);
+    }
+    if (cache->done_sem) {
+        vSemaphoreDelete(cache->done_sem);
+    }
+    free(cache);
+    return ret;
+}
+
+void shtc3_cache_delete(shtc3_cache_handle_t handle)
+{
+    shtc3_cache_t *cache = (shtc3_cache_t *) handle;
+
+    atomic_store(&cache->stop, true);
+    xTaskNotifyGive(cache->task);
+    xSemaphoreTake(cache->done_sem, portMAX_DELAY);
+
+    vEventGroupDelete(cache->events);
+    vSemaphoreDelete(cache->done_sem);
+    free(cache);
+}
+
+esp_err_t shtc3_cache_get(shtc3_cache_handle_t handle, shtc3_sample_t *sample)
+{
+    shtc3_cache_t *cache = (shtc3_cache_t *) handle;
+    bool valid;
+    unsigned seq;
+
+    assert(sample != NULL);
+
+    do {
+        seq = shtc3_seqlock_read_begin(&cache->seq);
+        valid = cache->valid;
+        *sample = cache->sample;
+    } while (shtc3_seqlock_read_retry(&cache->seq, seq));
+
+    if (!valid || esp_timer_get_time() - sample->timestamp_us >= (int64_t) cache->config.ttl_ms * 1000) {
+        shtc3_cache_request_refresh(cache);
+    }
+
+    return valid ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t shtc3_cache_wait_valid(shtc3_cache_handle_t handle, TickType_t timeout)
+{
+    shtc3_cache_t *cache = (shtc3_cache_t *) handle;
+
+    EventBits_t bits = xEventGroupWaitBits(cache->events, SHTC3_CACHE_VALID_BIT, pdFALSE, pdTRUE, timeout);
+    return (bits & SHTC3_CACHE_VALID_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void shtc3_cache_get_counters(shtc3_cache_handle_t handle, uint32_t *refreshes, uint32_t *errors)
+{
+    shtc3_cache_t *cache = (shtc3_cache_t *) handle;
+
+    if (refreshes) {
+        *refreshes = atomic_load(&cache->refreshes);
+    }
+    if (errors) {
+        *errors = atomic_load(&cache->errors);
+    }
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+// Only the first reader to see a stale value wakes the task
+static void shtc3_cache_request_refresh(shtc3_cache_t *cache)
+{
+    if (!atomic_exchange(&cache->refresh_pending, true)) {
+        xTaskNotifyGive(cache->task);
+    }
+}
+
+static void shtc3_cache_task(void *arg)
+{
+    shtc3_cache_t *cache = (shtc3_cache_t *) arg;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (atomic_load(&cache->stop)) {
+            break;
+        }
+
+        shtc3_raw_value_t raw;
+        esp_err_t ret = shtc3_measure(cache->sensor, cache->config.mode, &raw);
+        if (ret == ESP_OK) {
+            shtc3_seqlock_write_begin(&cache->seq);
+            cache->sample.timestamp_us = esp_timer_get_time();
+            cache->sample.temp_c = shtc3_temp_c_fixed(raw.temp, SHTC3_SCALE_CENTI);
+            cache->sample.humidity = shtc3_humidity_fixed(raw.humidity, SHTC3_SCALE_CENTI);
+            cache->valid = true;
+            shtc3_seqlock_write_end(&cache->seq);
+
+            atomic_fetch_add(&cache->refreshes, 1);
+            xEventGroupSetBits(cache->events, SHTC3_CACHE_VALID_BIT);
+        } else {
+            ESP_LOGD(TAG, "Refresh failed: %s", esp_err_to_name(ret));
+            atomic_fetch_add(&cache->errors, 1);
+            // Readers keep asking while the value is stale; don't hammer a failing sensor
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SHTC3_CACHE_RETRY_MS));
+            if (atomic_load(&cache->stop)) {
+                break;
+            }
+        }
+
+        atomic_store(&cache->refresh_pending, false);
+    }
+
+    xSemaphoreGive(cache->done_sem);
+    vTaskDelete(NULL);
+}
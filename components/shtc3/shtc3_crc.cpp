@@ -0,0 +1,78 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "sdkconfig.h"
+#include "shtc3_crc.h"
+
+namespace {
+
+constexpr uint8_t CRC_POLY = 0x31;
+constexpr uint8_t CRC_INIT = 0xFF;
+
+/* Entry i is the CRC register after shifting the top Bits of i << (8 - Bits) through the polynomial */
+template <unsigned Bits>
+constexpr std::array<uint8_t, (1u << Bits)> make_table()
+{
+    std::array<uint8_t, (1u << Bits)> table{};
+    for (unsigned i = 0; i < table.size(); i++) {
+        uint8_t crc = static_cast<uint8_t>(i << (8 - Bits));
+        for (unsigned b = 0; b < Bits; b++) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ CRC_POLY) : static_cast<uint8_t>(crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+#if CONFIG_SHTC3_CRC_NIBBLE_TABLE
+constexpr auto crc_table = make_table<4>();
+
+constexpr uint8_t crc_update(uint8_t crc, uint8_t byte)
+{
+    crc ^= byte;
+    crc = static_cast<uint8_t>(crc << 4) ^ crc_table[crc >> 4];
+    crc = static_cast<uint8_t>(crc << 4) ^ crc_table[crc >> 4];
+    return crc;
+}
+#else
+constexpr auto crc_table = make_table<8>();
+
+constexpr uint8_t crc_update(uint8_t crc, uint8_t byte)
+{
+    return crc_table[crc ^ byte];
+}
+#endif
+
+constexpr uint8_t crc_word(const uint8_t *word)
+{
+    return crc_update(crc_update(CRC_INIT, word[0]), word[1]);
+}
+
+/* Check value from the SHTC3 datasheet: CRC(0xBEEF) = 0x92 */
+constexpr uint8_t datasheet_example[] = {0xBE, 0xEF};
+static_assert(crc_word(datasheet_example) == 0x92, "CRC table does not match the SHTC3 datasheet");
+
+} // namespace
+
+uint8_t shtc3_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = CRC_INIT;
+
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_update(crc, data[i]);
+    }
+    return crc;
+}
+
+esp_err_t shtc3_crc_unpack(const uint8_t *frame, size_t word_count, uint16_t *words)
+{
+    uint8_t mismatch = 0;
+
+    for (size_t i = 0; i < word_count; i++, frame += SHTC3_CRC_WORD_SIZE) {
+        mismatch |= crc_word(frame) ^ frame[2];
+        if (words != nullptr) {
+            words[i] = static_cast<uint16_t>((frame[0] << 8) | frame[1]);
+        }
+    }
+    return (mismatch == 0) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
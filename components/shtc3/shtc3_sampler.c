@@ -0,0 +1,257 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "shtc3_sampler.h"
+#include "shtc3_seqlock.h"
+
+/*******************************************************************************
+* Types definitions
+*******************************************************************************/
+
+typedef struct {
+    int64_t sum;                    /*!< Sum of the samples in the window */
+    int32_t ewma_acc;               /*!< EWMA scaled by 2^ewma_shift */
+} shtc3_sampler_acc_t;
+
+typedef struct {
+    shtc3_handle_t sensor;
+    shtc3_sampler_config_t config;
+    TaskHandle_t task;
+    SemaphoreHandle_t done_sem;     /*!< Given by the task right before it exits */
+    atomic_bool stop;
+
+    /* Producer-only state */
+    shtc3_sampler_acc_t temp_acc;
+    shtc3_sampler_acc_t hum_acc;
+
+    /* Published state, guarded by seq: odd while the producer is writing */
+    atomic_uint seq;
+    shtc3_sampler_stats_t stats;
+    uint16_t head;                  /*!< Slot the next sample goes into */
+    shtc3_sample_t ring[];
+} shtc3_sampler_t;
+
+/*******************************************************************************
+* Function definitions
+*******************************************************************************/
+static void shtc3_sampler_task(void *arg);
+static void shtc3_sampler_push(shtc3_sampler_t *smp, const shtc3_sample_t *sample);
+static void shtc3_sampler_count_error(shtc3_sampler_t *smp);
+static int32_t shtc3_sampler_ewma(shtc3_sampler_t *smp, shtc3_sampler_acc_t *acc, int32_t value);
+
+/*******************************************************************************
+* Local variables
+*******************************************************************************/
+static const char *TAG = "SHTC3_SAMPLER";
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+esp_err_t shtc3_sampler_create(shtc3_handle_t sensor, const shtc3_sampler_config_t *config,
+                               shtc3_sampler_handle_t *handle_ret)
+{
+    esp_err_t ret = ESP_OK;
+
+    assert(sensor != NULL && config != NULL && handle_ret != NULL);
+    ESP_RETURN_ON_FALSE(config->mode < SHTC3_MODE_MAX && config->period_ms > 0 && config->window > 0 &&
+                        config->ewma_shift <= SHTC3_SAMPLER_MAX_EWMA_SHIFT,
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid configuration");
+
+    shtc3_sampler_t *smp = (shtc3_sampler_t *) calloc(1, sizeof(shtc3_sampler_t) + config->window * sizeof(shtc3_sample_t));
+    ESP_RETURN_ON_FALSE(smp != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+    smp->sensor = sensor;
+    smp->config = *config;
+    atomic_init(&smp->stop, false);
+    atomic_init(&smp->seq, 0);
+
+    smp->done_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(smp->done_sem != NULL, ESP_ERR_NO_MEM, err, TAG, "Not enough memory");
+
+    BaseType_t res = xTaskCreate(shtc3_sampler_task, "shtc3_sampler", config->task_stack, smp,
+                                 config->task_priority, &smp->task);
+    ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "Failed to create task");
+
+    *handle_ret = smp;
+    return ret;
+
+err:
+    if (smp->done_sem) {
+        vSemaphoreDelete(smp->done_sem);
+    }
+    free(smp);
+    return ret;
+}
+
+void shtc3_sampler_delete(shtc3_sampler_handle_t sampler)
+{
+    shtc3_sampler_t *smp = (shtc3_sampler_t *) sampler;
+
+    atomic_store(&smp->stop, true);
+    xTaskNotifyGive(smp->task);
+    xSemaphoreTake(smp->done_sem, portMAX_DELAY);
+
+    vSemaphoreDelete(smp->done_sem);
+    free(smp);
+}
+
+esp_err_t shtc3_sampler_get_latest(shtc3_sampler_handle_t sampler, shtc3_sample_t *sample)
+{
+    shtc3_sampler_t *smp = (shtc3_sampler_t *) sampler;
+    uint32_t samples;
+    unsigned seq;
+
+    assert(sample != NULL);
+
+    do {
+        seq = shtc3_seqlock_read_begin(&smp->seq);
+        samples = smp->stats.samples;
+        *sample = smp->stats.latest;
+    } while (shtc3_seqlock_read_retry(&smp->seq, seq));
+
+    return (samples > 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t shtc3_sampler_get_stats(shtc3_sampler_handle_t sampler, shtc3_sampler_stats_t *stats)
+{
+    shtc3_sampler_t *smp = (shtc3_sampler_t *) sampler;
+    unsigned seq;
+
+    assert(stats != NULL);
+
+    do {
+        seq = shtc3_seqlock_read_begin(&smp->seq);
+        *stats = smp->stats;
+    } while (shtc3_seqlock_read_retry(&smp->seq, seq));
+
+    return (stats->samples > 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+size_t shtc3_sampler_get_history(shtc3_sampler_handle_t sampler, shtc3_sample_t *samples, size_t max_count)
+{
+    shtc3_sampler_t *smp = (shtc3_sampler_t *) sampler;
+    const uint16_t window = smp->config.window;
+    size_t n;
+    unsigned seq;
+
+    assert(samples != NULL || max_count == 0);
+
+    do {
+        seq = shtc3_seqlock_read_begin(&smp->seq);
+        n = (smp->stats.count < max_count) ? smp->stats.count : max_count;
+        uint16_t idx = smp->head;
+        for (size_t i = 0; i < n; i++) {
+            idx = (idx == 0) ? window - 1 : idx - 1;
+            samples[i] = smp->ring[idx];
+        }
+    } while (shtc3_seqlock_read_retry(&smp->seq, seq));
+
+    return n;
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static void shtc3_sampler_task(void *arg)
+{
+    shtc3_sampler_t *smp = (shtc3_sampler_t *) arg;
+    const TickType_t period = pdMS_TO_TICKS(smp->config.period_ms) ? pdMS_TO_TICKS(smp->config.period_ms) : 1;
+    TickType_t next_wake = xTaskGetTickCount();
+
+    while (!atomic_load(&smp->stop)) {
+        shtc3_raw_value_t raw;
+        esp_err_t ret = shtc3_measure(smp->sensor, smp->config.mode, &raw);
+        if (ret == ESP_OK) {
+            const shtc3_sample_t sample = {
+                .timestamp_us = esp_timer_get_time(),
+                .temp_c = shtc3_temp_c_fixed(raw.temp, SHTC3_SCALE_CENTI),
+                .humidity = shtc3_humidity_fixed(raw.humidity, SHTC3_SCALE_CENTI),
+            };
+            shtc3_sampler_push(smp, &sample);
+        } else {
+            ESP_LOGD(TAG, "Measurement failed: %s", esp_err_to_name(ret));
+            shtc3_sampler_count_error(smp);
+        }
+
+        // Fixed-rate schedule; skip missed slots instead of bursting to catch up
+        next_wake += period;
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(next_wake - now) <= 0) {
+            next_wake = now + period;
+        }
+        ulTaskNotifyTake(pdTRUE, next_wake - now);
+    }
+
+    xSemaphoreGive(smp->done_sem);
+    vTaskDelete(NULL);
+}
+
+static void shtc3_sampler_push(shtc3_sampler_t *smp, const shtc3_sample_t *sample)
+{
+    const uint16_t window = smp->config.window;
+    const bool full = (smp->stats.count == window);
+    shtc3_sampler_stats_t stats = smp->stats;
+
+    // The slot about to be overwritten still holds the sample leaving the window
+    if (full) {
+        smp->temp_acc.sum -= smp->ring[smp->head].temp_c;
+        smp->hum_acc.sum -= smp->ring[smp->head].humidity;
+    } else {
+        stats.count++;
+    }
+    smp->temp_acc.sum += sample->temp_c;
+    smp->hum_acc.sum += sample->humidity;
+    stats.temp_c.mean = (int32_t)(smp->temp_acc.sum / stats.count);
+    stats.humidity.mean = (int32_t)(smp->hum_acc.sum / stats.count);
+
+    stats.temp_c.ewma = shtc3_sampler_ewma(smp, &smp->temp_acc, sample->temp_c);
+    stats.humidity.ewma = shtc3_sampler_ewma(smp, &smp->hum_acc, sample->humidity);
+
+    // The window is short and this runs once per period, so min/max are rescanned
+    stats.temp_c.min = stats.temp_c.max = sample->temp_c;
+    stats.humidity.min = stats.humidity.max = sample->humidity;
+    for (uint16_t i = 0; i < smp->stats.count; i++) {
+        if (full && i == smp->head) {
+            continue;
+        }
+        const shtc3_sample_t *s = &smp->ring[i];
+        stats.temp_c.min = (s->temp_c < stats.temp_c.min) ? s->temp_c : stats.temp_c.min;
+        stats.temp_c.max = (s->temp_c > stats.temp_c.max) ? s->temp_c : stats.temp_c.max;
+        stats.humidity.min = (s->humidity < stats.humidity.min) ? s->humidity : stats.humidity.min;
+        stats.humidity.max = (s->humidity > stats.humidity.max) ? s->humidity : stats.humidity.max;
+    }
+
+    stats.samples++;
+    stats.latest = *sample;
+
+    shtc3_seqlock_write_begin(&smp->seq);
+    smp->ring[smp->head] = *sample;
+    smp->head = (smp->head + 1 == window) ? 0 : smp->head + 1;
+    smp->stats = stats;
+    shtc3_seqlock_write_end(&smp->seq);
+}
+
+static void shtc3_sampler_count_error(shtc3_sampler_t *smp)
+{
+    shtc3_seqlock_write_begin(&smp->seq);
+    smp->stats.errors++;
+    shtc3_seqlock_write_end(&smp->seq);
+}
+
+static int32_t shtc3_sampler_ewma(shtc3_sampler_t *smp, shtc3_sampler_acc_t *acc, int32_t value)
+{
+    const uint8_t shift = smp->config.ewma_shift;
+
+    if (smp->stats.samples == 0) {
+        acc->ewma_acc = value * (1 << shift);
+    } else {
+        acc->ewma_acc += value - (acc->ewma_acc >> shift);
+    }
+    return acc->ewma_acc >> shift;
+}
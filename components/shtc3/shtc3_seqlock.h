@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*
+ * Single-writer sequence counter (seqlock) used to publish sensor state to any
+ * number of readers without a mutex. The counter is odd while the writer is
+ * updating; readers copy the data and retry if the counter moved.
+ *
+ * The writer keeps the scheduler suspended while the counter is odd, so on a
+ * single core a reader never waits on a preempted writer; on two cores it
+ * spins for the length of a struct copy at most. Only one task may write.
+ */
+
+static inline void shtc3_seqlock_write_begin(atomic_uint *seq)
+{
+    vTaskSuspendAll();
+    atomic_fetch_add_explicit(seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void shtc3_seqlock_write_end(atomic_uint *seq)
+{
+    atomic_fetch_add_explicit(seq, 1, memory_order_release);
+    xTaskResumeAll();
+}
+
+static inline unsigned shtc3_seqlock_read_begin(atomic_uint *seq)
+{
+    unsigned start;
+
+    while ((start = atomic_load_explicit(seq, memory_order_acquire)) & 1) {
+    }
+    return start;
+}
+
+static inline bool shtc3_seqlock_read_retry(atomic_uint *seq, unsigned start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(seq, memory_order_relaxed) != start;
+}
@@ -1,127 +1,51 @@
 #include <stdio.h>
-#include <math.h>
-#include "driver/i2c.h"
+#include <inttypes.h>
+#include "driver/i2c_master.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "shtc3.h"
 
 #define I2C_MASTER_SCL_IO           8
 #define I2C_MASTER_SDA_IO           10
 #define I2C_MASTER_NUM              I2C_NUM_0
-#define I2C_MASTER_FREQ_HZ          100000
-#define I2C_MASTER_TX_BUF_DISABLE   0
-#define I2C_MASTER_RX_BUF_DISABLE   0
-
-#define SHTC3_SENSOR_ADDR 0x70 
-
-
-
-// SHTC3 Commands
-#define CMD_WAKEUP                  0x3517
-#define CMD_SLEEP                   0xB098
-#define CMD_READ_T_RH               0x7866
-
-// CRC Polynomial for SHTC3 is 0x31 (x⁸ + x⁵ + x⁴ + 1)
-uint8_t calculate_crc(uint8_t data[], int len) {
-    uint8_t crc = 0xFF;
-    for (int i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x80)
-                crc = (crc << 1) ^ 0x31;
-            else
-                crc <<= 1;
-        }
-    }
-    return crc;
-}
-
-esp_err_t shtc3_send_command(uint16_t cmd) {
-    uint8_t write_buf[2] = { cmd >> 8, cmd & 0xFF };
-    return i2c_master_write_to_device(I2C_MASTER_NUM, SHTC3_SENSOR_ADDR,
-                                      write_buf, 2, pdMS_TO_TICKS(100));
-}
-
-esp_err_t shtc3_read_data(uint16_t* temp_raw, uint16_t* hum_raw) {
-    // Send measurement trigger
-    esp_err_t err = shtc3_send_command(CMD_READ_T_RH);
-    if (err != ESP_OK) {
-        printf("Failed to send read command: %s\n", esp_err_to_name(err));
-        return err;
-    }
-
-    vTaskDelay(pdMS_TO_TICKS(20));  // Datasheet recommends ~15ms
-
-    uint8_t data[6];
-    err = i2c_master_read_from_device(I2C_MASTER_NUM, SHTC3_SENSOR_ADDR,
-                                      data, 6, pdMS_TO_TICKS(100));
-    if (err != ESP_OK) {
-        printf("Sensor read failed: %s\n", esp_err_to_name(err));
-        return err;
-    }
-
-    // Check CRCs
-    if (calculate_crc(data, 2) != data[2] || calculate_crc(&data[3], 2) != data[5]) {
-        printf("CRC check failed\n");
-        return ESP_ERR_INVALID_CRC;
-    }
-
-    *temp_raw = (data[0] << 8) | data[1];
-    *hum_raw  = (data[3] << 8) | data[4];
-    return ESP_OK;
-}
+#define I2C_PROBE_TIMEOUT_MS        100
 
+static i2c_master_bus_handle_t bus;
+static shtc3_handle_t shtc3;
 
 void print_temperature_and_humidity() {
-    shtc3_send_command(CMD_WAKEUP);
-    vTaskDelay(pdMS_TO_TICKS(1));  // wake-up delay
-
-    uint16_t raw_temp, raw_hum;
-    esp_err_t raw = shtc3_read_data(&raw_temp, &raw_hum);
-
-    //shtc3_send_command(CMD_SLEEP);  // always power down
-
-    /*
+    shtc3_raw_value_t raw;
+    esp_err_t err = shtc3_measure(shtc3, SHTC3_MODE_NORMAL_T_FIRST, &raw);
     if (err != ESP_OK) {
         printf("Sensor read failed: %s\n", esp_err_to_name(err));
         return;
-    }*/
-    
+    }
 
-    // Convert raw values to physical values (from datasheet)
-    float temp_C = -45 + 175 * (raw_temp / 65535.0);
-    float temp_F = temp_C * 9.0 / 5.0 + 32.0;
-    float humidity = 100 * (raw_hum / 65535.0);
-    //printf("Raw temp: 0x%04X, Raw hum: 0x%04X\n", raw_temp, raw_hum);
+    // Convert raw values to whole degrees / percent (integer-only, same rounding as %.0f)
+    int32_t temp_C = shtc3_temp_c_fixed(raw.temp, SHTC3_SCALE_UNIT);
+    int32_t temp_F = shtc3_temp_f_fixed(raw.temp, SHTC3_SCALE_UNIT);
+    int32_t humidity = shtc3_humidity_fixed(raw.humidity, SHTC3_SCALE_UNIT);
+    //printf("Raw temp: 0x%04X, Raw hum: 0x%04X\n", raw.temp, raw.humidity);
 
-    printf("Temperature is %.0fC (or %.0fF) with a %.0f%% humidity\n",
-           round(temp_C), round(temp_F), round(humidity));
+    printf("Temperature is %" PRId32 "C (or %" PRId32 "F) with a %" PRId32 "%% humidity\n",
+           temp_C, temp_F, humidity);
 }
 
 void i2c_master_init() {
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
+    i2c_master_bus_config_t conf = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .i2c_port = I2C_MASTER_NUM,
         .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
+        .sda_io_num = I2C_MASTER_SDA_IO,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
     };
-    i2c_param_config(I2C_MASTER_NUM, &conf);
-    i2c_driver_install(I2C_MASTER_NUM, conf.mode,
-                       I2C_MASTER_RX_BUF_DISABLE,
-                       I2C_MASTER_TX_BUF_DISABLE, 0);
+    ESP_ERROR_CHECK(i2c_new_master_bus(&conf, &bus));
 }
 void i2c_scanner() {
     printf("Scanning I2C bus...\n");
     for (uint8_t addr = 1; addr < 127; addr++) {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_stop(cmd);
-        esp_err_t err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(100));
-        i2c_cmd_link_delete(cmd);
-
-        if (err == ESP_OK) {
+        if (i2c_master_probe(bus, addr, I2C_PROBE_TIMEOUT_MS) == ESP_OK) {
             printf("Device found at 0x%02X\n", addr);
         }
     }
@@ -131,11 +55,16 @@ void i2c_scanner() {
 void app_main() {
     i2c_master_init();
     i2c_scanner(); 
+
+    // The driver wakes the sensor for each measurement and puts it back to sleep
+    shtc3_config_t cfg = {
+        .dev_addr = SHTC3_I2C_ADDRESS,
+        .auto_sleep = true,
+    };
+    ESP_ERROR_CHECK(shtc3_create(bus, &cfg, &shtc3));
+
     while (1) {
-        shtc3_send_command(CMD_WAKEUP);
         print_temperature_and_humidity();
-        shtc3_send_command(CMD_SLEEP); 
         vTaskDelay(pdMS_TO_TICKS(1000));  // Print every 5 seconds
     }
 }
-
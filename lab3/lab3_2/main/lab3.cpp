@@ -7,10 +7,29 @@ extern "C" {
 #include "freertos/task.h"
 #include <stdio.h>
 
+#define I2C_MASTER_NUM      I2C_NUM_0
+#define I2C_MASTER_SDA_IO   10
+#define I2C_MASTER_SCL_IO   8
+
+static i2c_master_bus_handle_t i2c_bus;
+
+static esp_err_t i2c_master_init() {
+    i2c_master_bus_config_t conf = {};
+    conf.clk_source = I2C_CLK_SRC_DEFAULT;
+    conf.i2c_port = I2C_MASTER_NUM;
+    conf.sda_io_num = (gpio_num_t)I2C_MASTER_SDA_IO;
+    conf.scl_io_num = (gpio_num_t)I2C_MASTER_SCL_IO;
+    conf.glitch_ignore_cnt = 7;
+    conf.flags.enable_internal_pullup = true;
+    return i2c_new_master_bus(&conf, &i2c_bus);
+}
+
 void app_main() {
-    lcd myLCD;
+    ESP_ERROR_CHECK(i2c_master_init());
+
+    lcd myLCD(i2c_bus);
 
-    myLCD.init();
+    ESP_ERROR_CHECK(myLCD.init());
 
     myLCD.setCursor(0, 0);
     myLCD.printstr("Hello CSE121!");
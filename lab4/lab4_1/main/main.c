@@ -5,17 +5,32 @@
 #include "freertos/task.h"
 #include "driver/i2c_master.h"
 #include "esp_log.h"
+#include "nvs_flash.h"
 #include "icm42670.h"
+#include "icm42670_calib.h"
 
 #define TAG "TILT"
 
 #define SDA_PIN 10
 #define SCL_PIN 8
-#define ACCEL_THRESHOLD 1500
+#define INT_PIN 4               // Wired to the ICM-42670 INT1 pin
+#define ACCEL_THRESHOLD 0.18f   // Tilt in g, after bias removal
+#define FIFO_WATERMARK  25      // 250 ms at 100 Hz
+#define FIFO_BATCH_MAX  32      // Watermark plus whatever lands while the batch is read
+#define WOM_THRESHOLD   8       // Sample-to-sample change that counts as motion, 1/256 g per LSB
+#define IDLE_BATCHES    4       // FLAT this long (1 s) and the loop sleeps until motion
+#define CALIB_SAMPLES   200     // 2 s at 100 Hz, board flat and still on first boot
 
 static icm42670_handle_t icm = NULL;
 
 void app_main() {
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
     // 1. Create I2C bus
     i2c_master_bus_config_t i2c_config = {
         .clk_source = I2C_CLK_SRC_DEFAULT,
@@ -42,20 +57,69 @@ void app_main() {
         .gyro_odr = GYRO_ODR_100HZ,
     };
     ESP_ERROR_CHECK(icm42670_config(icm, &cfg));
+    // Bias from NVS, or measured once on first boot with the board flat
+    ESP_ERROR_CHECK(icm42670_calib_load_or_estimate(icm, ICM42670_CALIB_NVS_KEY, CALIB_SAMPLES, 10, NULL));
+
+    // Samples queue up in the sensor's FIFO; INT1 pulses at the watermark
+    // and each pass drains them in one burst
+    icm42670_fifo_cfg_t fifo_cfg = {
+        .packet = ICM42670_FIFO_PACKET_ACCEL,
+        .watermark = FIFO_WATERMARK,
+        .stop_on_full = false,
+    };
+    ESP_ERROR_CHECK(icm42670_fifo_config(icm, &fifo_cfg));
 
-    vTaskDelay(pdMS_TO_TICKS(100));
+    icm42670_int_cfg_t int_cfg = {
+        .gpio = INT_PIN,
+        .source = ICM42670_INT_FIFO_THS,
+    };
+    ESP_ERROR_CHECK(icm42670_int_enable(icm, &int_cfg));
+
+    icm42670_apex_cfg_t apex_cfg = {
+        .features = ICM42670_APEX_WOM,
+        .wom_threshold = WOM_THRESHOLD,
+        .wom_vs_previous = true,
+    };
+    ESP_ERROR_CHECK(icm42670_apex_config(icm, &apex_cfg));
     
     // 4. Main tilt loop
+    static icm42670_fifo_sample_t batch[FIFO_BATCH_MAX];
+    int64_t last_us = 0;
+    int flat_batches = 0;
     while (1) {
-        icm42670_raw_value_t raw;
-        if (icm42670_get_acce_raw_value(icm, &raw) != ESP_OK) {
+        int64_t now_us = 0;
+        // On a timeout drain anyway: a FIFO left above the watermark never pulses again
+        if (icm42670_int_wait(icm, pdMS_TO_TICKS(1000), &now_us) != ESP_OK) {
+            ESP_LOGW(TAG, "No FIFO interrupt");
+        }
+
+        size_t n = 0;
+        if (icm42670_fifo_read(icm, batch, FIFO_BATCH_MAX, &n) != ESP_OK) {
             ESP_LOGE(TAG, "Accel read failed");
             continue;
         }
+        if (n == 0) {
+            continue;
+        }
+        if (now_us && last_us) {
+            ESP_LOGD(TAG, "%u samples, %lld us since the last batch", (unsigned)n, now_us - last_us);
+        }
+        last_us = now_us;
 
-        int16_t ax = raw.x;
-        int16_t ay = raw.y;
-        
+        // Average the batch so one noisy sample can't flip the direction
+        int32_t sum_x = 0, sum_y = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum_x += batch[i].acce.x;
+            sum_y += batch[i].acce.y;
+        }
+        icm42670_raw_value_t mean = {
+            .x = sum_x / (int32_t)n,
+            .y = sum_y / (int32_t)n,
+        };
+        icm42670_value_t acce;
+        icm42670_acce_raw_to_value(icm, &mean, &acce);
+        float ax = acce.x;
+        float ay = acce.y;
 
         char direction[32] = "";
         if (ay > ACCEL_THRESHOLD) strcat(direction, "UP ");
@@ -66,10 +130,18 @@ void app_main() {
         if (direction[0]) {
             direction[strlen(direction) - 1] = '\0';
             ESP_LOGI(TAG, "%s", direction);
+            flat_batches = 0;
         } else {
             ESP_LOGI(TAG, "FLAT");
+            if (++flat_batches >= IDLE_BATCHES) {
+                // Hand INT1 to wake-on-motion and sleep until the board moves
+                ESP_LOGI(TAG, "Idle, waiting for motion");
+                ESP_ERROR_CHECK(icm42670_apex_wait_motion(icm, portMAX_DELAY));
+                // The FIFO kept filling while idle; start again from fresh samples
+                icm42670_fifo_flush(icm);
+                flat_batches = 0;
+                last_us = 0;
+            }
         }
-
-        vTaskDelay(pdMS_TO_TICKS(250));
     }
 }
@@ -1,5 +1,6 @@
 /* FILE: main/main.c */
 #include <stdio.h>
+#include <math.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -16,6 +17,7 @@
 #define MOUSE_LEFT_BUTTON 0x01
 
 #include "icm42670.h"
+#include "icm42670_calib.h"
 #include "hid_dev.h"
 
 #define TAG "TILT_MOUSE"
@@ -23,12 +25,21 @@
 // I2C
 #define SDA_PIN 10
 #define SCL_PIN 8
-#define ACCEL_THRESH_BIT 1500
-#define ACCEL_THRESH_LOT 4000
+#define INT_PIN 4           // Wired to the ICM-42670 INT1 pin
+#define ACCEL_THRESH_BIT 0.18f // Tilt in g, after bias removal
+#define ACCEL_THRESH_LOT 0.49f
 
 #define STEP_BIT 2
 #define STEP_LOT 6
-#define REPORT_DELAY_MS 20
+#define INT_TIMEOUT_MS 100  // Data-ready pulses every 20 ms at the 50 Hz ODR
+
+// The ICM-42670-P has no tap engine, so taps are picked out of the samples
+// the loop reads anyway: a Z jump between samples that tilting can't produce
+#define TAP_THRESH 0.73f    // g
+#define TAP_HOLDOFF 25      // Samples before another tap counts, 0.5 s
+#define IDLE_SAMPLES 150    // 3 s without movement, then sleep until wake-on-motion
+#define WOM_THRESHOLD 8     // Sample-to-sample change that counts as motion, 1/256 g per LSB
+#define CALIB_SAMPLES 100   // 2 s at 50 Hz, board flat and still on first boot
 
 static icm42670_handle_t icm = NULL;
 static uint16_t hid_conn_id = 0;
@@ -112,14 +123,16 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
 }
 
 
-// Tilt Mouse Logic with Auto-Click
+// Tilt Mouse Logic with Tap-to-Click
 void tilt_mouse_task(void *arg) {
     vTaskDelay(pdMS_TO_TICKS(1000)); // Wait for BLE stack
 
     static int accel_multiplier_x = 1;
     static int accel_multiplier_y = 1;
-    static int still_counter = 0;
-    static bool clicked = false;
+    int idle_count = 0;
+    int tap_holdoff = 0;
+    bool have_last_z = false;
+    float last_z = 0;
 
     while (1) {
         if (!sec_conn) {
@@ -127,14 +140,30 @@ void tilt_mouse_task(void *arg) {
             continue;
         }
 
-        icm42670_raw_value_t raw;
-        if (icm42670_get_acce_raw_value(icm, &raw) != ESP_OK) {
+        // One report per sample: wait for data-ready instead of a fixed delay
+        if (icm42670_int_wait(icm, pdMS_TO_TICKS(INT_TIMEOUT_MS), NULL) != ESP_OK) {
+            ESP_LOGW(TAG, "No data-ready interrupt");
+            continue;
+        }
+
+        icm42670_value_t acce;
+        if (icm42670_get_acce_value(icm, &acce) != ESP_OK) {
             ESP_LOGE(TAG, "Accel read failed");
             continue;
         }
 
-        int16_t ax = raw.x;
-        int16_t ay = raw.y;
+        float ax = acce.x;
+        float ay = acce.y;
+        bool tap = false;
+        if (tap_holdoff > 0) {
+            tap_holdoff--;
+        } else if (have_last_z && fabsf(acce.z - last_z) > TAP_THRESH) {
+            tap = true;
+            tap_holdoff = TAP_HOLDOFF;
+        }
+        last_z = acce.z;
+        have_last_z = true;
+
         int x_delta = 0;
         int y_delta = 0;
 
@@ -181,24 +210,23 @@ void tilt_mouse_task(void *arg) {
         x_delta *= accel_multiplier_x;
         y_delta *= accel_multiplier_y;
 
-        if (x_delta != 0 || y_delta != 0) {
+        if (tap) {
+            ESP_LOGI(TAG, "Tap click");
+            esp_hidd_send_mouse_value(hid_conn_id, MOUSE_LEFT_BUTTON, 0, 0);
+            vTaskDelay(pdMS_TO_TICKS(30));
+            esp_hidd_send_mouse_value(hid_conn_id, 0, 0, 0);
+            idle_count = 0;
+        } else if (x_delta != 0 || y_delta != 0) {
             esp_hidd_send_mouse_value(hid_conn_id, 0, x_delta, y_delta);
             ESP_LOGI(TAG, "Move X:%d Y:%d", x_delta, y_delta);
-            still_counter = 0;
-            clicked = false;
-        } else {
-            esp_hidd_send_mouse_value(hid_conn_id, 0, 0, 0);
-            still_counter++;
-            if (still_counter >= 50 && !clicked) { // ~1s
-                ESP_LOGI(TAG, "Auto-click triggered");
-                esp_hidd_send_mouse_value(hid_conn_id, MOUSE_LEFT_BUTTON, 0, 0);
-                vTaskDelay(pdMS_TO_TICKS(30));
-                esp_hidd_send_mouse_value(hid_conn_id, 0, 0, 0);
-                clicked = true;
-            }
+            idle_count = 0;
+        } else if (++idle_count >= IDLE_SAMPLES) {
+            // Nothing to report: stop reading until the board moves again
+            ESP_LOGI(TAG, "Idle, waiting for motion");
+            ESP_ERROR_CHECK(icm42670_apex_wait_motion(icm, portMAX_DELAY));
+            idle_count = 0;
+            have_last_z = false;
         }
-
-        vTaskDelay(pdMS_TO_TICKS(REPORT_DELAY_MS));
     }
 }
 
@@ -228,12 +256,24 @@ void app_main(void) {
     ESP_ERROR_CHECK(icm42670_gyro_set_pwr(icm, GYRO_PWR_OFF));
     icm42670_cfg_t cfg = {
         .acce_fs = ACCE_FS_4G,
-        .acce_odr = ACCE_ODR_100HZ,
+        .acce_odr = ACCE_ODR_50HZ,
         .gyro_fs = GYRO_FS_250DPS,
-        .gyro_odr = GYRO_ODR_100HZ,
+        .gyro_odr = GYRO_ODR_50HZ,
     };
     ESP_ERROR_CHECK(icm42670_config(icm, &cfg));
-    vTaskDelay(pdMS_TO_TICKS(100));
+    // Bias from NVS, or measured once on first boot with the board flat
+    ESP_ERROR_CHECK(icm42670_calib_load_or_estimate(icm, ICM42670_CALIB_NVS_KEY, CALIB_SAMPLES, 20, NULL));
+    icm42670_int_cfg_t int_cfg = {
+        .gpio = INT_PIN,
+        .source = ICM42670_INT_DATA_READY,
+    };
+    ESP_ERROR_CHECK(icm42670_int_enable(icm, &int_cfg));
+    icm42670_apex_cfg_t apex_cfg = {
+        .features = ICM42670_APEX_WOM,
+        .wom_threshold = WOM_THRESHOLD,
+        .wom_vs_previous = true,
+    };
+    ESP_ERROR_CHECK(icm42670_apex_config(icm, &apex_cfg));
 
     // Init Bluetooth
     ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
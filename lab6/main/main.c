@@ -2,107 +2,78 @@
 #include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
 #include "driver/gpio.h"
 #include "esp_timer.h"
 #include "esp_rom_sys.h"  // for esp_rom_delay_us
+#include "shtc3.h"
+#include "shtc3_cache.h"
 
 #define I2C_MASTER_SCL_IO           8
 #define I2C_MASTER_SDA_IO           10
 #define I2C_MASTER_NUM              I2C_NUM_0
-#define I2C_MASTER_FREQ_HZ          100000
-#define I2C_MASTER_TX_BUF_DISABLE   0
-#define I2C_MASTER_RX_BUF_DISABLE   0
-
-#define SHTC3_SENSOR_ADDR 0x70
-#define CMD_WAKEUP                  0x3517
-#define CMD_SLEEP                   0xB098
-#define CMD_READ_T_RH               0x7866
 
 #define TRIGGER_GPIO GPIO_NUM_2
 #define ECHO_GPIO GPIO_NUM_3
 
-
-uint8_t calculate_crc(uint8_t data[], int len) {
-    uint8_t crc = 0xFF;
-    for (int i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++)
-            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+#define TEMP_CACHE_TTL_MS   10000   // Air temperature drifts over minutes
+#define SONAR_PERIOD_MS     60      // Lets the previous ping's echoes die out
+
+static i2c_master_bus_handle_t bus;
+static shtc3_handle_t shtc3;
+static shtc3_cache_handle_t temp_cache;
+static int64_t init_retry_us;       // No new init attempt before this esp_timer time
+static const shtc3_config_t shtc3_cfg = {
+    .dev_addr = SHTC3_I2C_ADDRESS,
+    .auto_sleep = true,
+};
+
+// Sensor and cache; safe to call again if the sensor was missing at boot.
+// After a failure it waits one TTL before trying again: each try is a full
+// sensor create with bus retries and backoff, too slow for every sonar pass.
+esp_err_t temp_cache_init() {
+    int64_t now = esp_timer_get_time();
+    if (now < init_retry_us) return ESP_ERR_NOT_FOUND;
+    init_retry_us = now + TEMP_CACHE_TTL_MS * 1000LL;
+
+    if (!shtc3) {
+        esp_err_t err = shtc3_create(bus, &shtc3_cfg, &shtc3);
+        if (err != ESP_OK) return err;
     }
-    return crc;
-}
-
-esp_err_t shtc3_send_command(uint16_t cmd) {
-    uint8_t write_buf[2] = { cmd >> 8, cmd & 0xFF };
-    return i2c_master_write_to_device(I2C_MASTER_NUM, SHTC3_SENSOR_ADDR,
-                                      write_buf, 2, pdMS_TO_TICKS(100));
-}
-
-esp_err_t shtc3_read_data(uint16_t* temp_raw, uint16_t* hum_raw) {
-    esp_err_t err = shtc3_send_command(CMD_READ_T_RH);
-    if (err != ESP_OK) return err;
-
-    vTaskDelay(pdMS_TO_TICKS(20));  // wait for measurement
-
-    uint8_t data[6];
-    err = i2c_master_read_from_device(I2C_MASTER_NUM, SHTC3_SENSOR_ADDR,
-                                      data, 6, pdMS_TO_TICKS(100));
-    if (err != ESP_OK) return err;
-
-    if (calculate_crc(data, 2) != data[2] || calculate_crc(&data[3], 2) != data[5])
-        return ESP_ERR_INVALID_CRC;
-
-    *temp_raw = (data[0] << 8) | data[1];
-    *hum_raw  = (data[3] << 8) | data[4];
-    return ESP_OK;
+    shtc3_cache_config_t cache_cfg = SHTC3_CACHE_CONFIG_DEFAULT();
+    cache_cfg.ttl_ms = TEMP_CACHE_TTL_MS;
+    return shtc3_cache_create(shtc3, &cache_cfg, &temp_cache);
 }
 
 void i2c_master_init() {
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
+    i2c_master_bus_config_t conf = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .i2c_port = I2C_MASTER_NUM,
         .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
+        .sda_io_num = I2C_MASTER_SDA_IO,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
     };
-    i2c_param_config(I2C_MASTER_NUM, &conf);
-    i2c_driver_install(I2C_MASTER_NUM, conf.mode,
-                       I2C_MASTER_RX_BUF_DISABLE,
-                       I2C_MASTER_TX_BUF_DISABLE, 0);
+    ESP_ERROR_CHECK(i2c_new_master_bus(&conf, &bus));
+    if (temp_cache_init() == ESP_OK) {
+        shtc3_cache_wait_valid(temp_cache, pdMS_TO_TICKS(100));
+    }
 }
 
+// Never waits on the sensor; a stale value triggers a refresh in the background
 float get_temperature_celsius() {
-    uint16_t raw_temp, raw_hum;
-
-    shtc3_send_command(CMD_WAKEUP);
-    vTaskDelay(pdMS_TO_TICKS(1));
-    esp_err_t err = shtc3_read_data(&raw_temp, &raw_hum);
+    shtc3_sample_t sample;
 
-    if (err != ESP_OK) {
-       // printf("First temp read failed: %s. Retrying...\n", esp_err_to_name(err));
-        vTaskDelay(pdMS_TO_TICKS(10));
-        err = shtc3_read_data(&raw_temp, &raw_hum);
+    if (!temp_cache && temp_cache_init() != ESP_OK) {
+        return -1;
     }
 
-    if (err != ESP_OK) {
-       // printf("Second read failed: %s. Resetting I2C driver...\n", esp_err_to_name(err));
-        shtc3_send_command(CMD_SLEEP);
-        i2c_driver_delete(I2C_MASTER_NUM);
-        i2c_master_init();
-        shtc3_send_command(CMD_WAKEUP);
-        vTaskDelay(pdMS_TO_TICKS(1));
-        err = shtc3_read_data(&raw_temp, &raw_hum);
-        if (err != ESP_OK) {
-            shtc3_send_command(CMD_SLEEP);
-            //printf("Final read failed: %s. Giving up.\n", esp_err_to_name(err));
-            return -1;
-        }
+    if (shtc3_cache_get(temp_cache, &sample) != ESP_OK) {
+        //printf("No temperature yet\n");
+        return -1;
     }
 
-    shtc3_send_command(CMD_SLEEP);
-    return -45 + 175 * (raw_temp / 65535.0);
+    return sample.temp_c / 100.0f;
 }
 
 
@@ -169,7 +140,7 @@ void app_main() {
                //printf("No echo received (distance = 0)\n");
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(500));
+        vTaskDelay(pdMS_TO_TICKS(SONAR_PERIOD_MS));
     }
 }
 
@@ -1,6 +1,6 @@
 #include <string.h>
 #include <stdio.h>
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_err.h"
@@ -15,58 +15,30 @@
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
+#include "shtc3.h"
+#include "shtc3_sampler.h"
 
 // —— I2C / SHTC3 sensor setup ——  
 #define I2C_MASTER_SCL_IO         8  
 #define I2C_MASTER_SDA_IO         10  
 #define I2C_MASTER_NUM            I2C_NUM_0  
-#define I2C_MASTER_FREQ_HZ        100000  
-#define I2C_MASTER_TX_BUF_DISABLE 0  
-#define I2C_MASTER_RX_BUF_DISABLE 0  
-#define SHTC3_ADDR                0x70  
-#define SHTC3_READ_CMD            0x7CA2  
 
 static const char *TAG = "sensor_http";
 
+static i2c_master_bus_handle_t i2c_bus;
+static shtc3_handle_t shtc3;
+static shtc3_sampler_handle_t sampler;
+
 static esp_err_t i2c_master_init(void) {
-    i2c_config_t conf = {
-        .mode               = I2C_MODE_MASTER,
+    i2c_master_bus_config_t conf = {
+        .clk_source         = I2C_CLK_SRC_DEFAULT,
+        .i2c_port           = I2C_MASTER_NUM,
         .sda_io_num         = I2C_MASTER_SDA_IO,
         .scl_io_num         = I2C_MASTER_SCL_IO,
-        .sda_pullup_en      = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en      = GPIO_PULLUP_ENABLE,
-        .master.clk_speed   = I2C_MASTER_FREQ_HZ,
+        .glitch_ignore_cnt  = 7,
+        .flags.enable_internal_pullup = true,
     };
-    esp_err_t err = i2c_param_config(I2C_MASTER_NUM, &conf);
-    if (err != ESP_OK) return err;
-    return i2c_driver_install(
-        I2C_MASTER_NUM,
-        I2C_MODE_MASTER,
-        I2C_MASTER_RX_BUF_DISABLE,
-        I2C_MASTER_TX_BUF_DISABLE,
-        0
-    );
-}
-
-static esp_err_t shtc3_read_data(uint8_t* data, size_t len) {
-    uint8_t cmd[2] = { (SHTC3_READ_CMD >> 8) & 0xFF, SHTC3_READ_CMD & 0xFF };
-    esp_err_t err = i2c_master_write_to_device(
-        I2C_MASTER_NUM, SHTC3_ADDR, cmd, sizeof(cmd),
-        pdMS_TO_TICKS(1000)
-    );
-    if (err != ESP_OK) return err;
-    return i2c_master_read_from_device(
-        I2C_MASTER_NUM, SHTC3_ADDR, data, len,
-        pdMS_TO_TICKS(1000)
-    );
-}
-
-static float convert_temperature(uint16_t raw) {
-    return (raw * 175.0f / 65535.0f) - 45.0f;
-}
-
-static float convert_humidity(uint16_t raw) {
-    return (raw * 100.0f / 65535.0f);
+    return i2c_new_master_bus(&conf, &i2c_bus);
 }
 
 // —— HTTP POST setup ——  
@@ -93,12 +65,18 @@ void app_main(void)
     ESP_ERROR_CHECK(i2c_master_init());
     vTaskDelay(pdMS_TO_TICKS(100));  // sensor power-up delay
 
-    // 2.5) Wake up SHTC3
-    uint8_t wake_cmd[2] = { 0x35, 0x17 };  // wakeup command
-    i2c_master_write_to_device(
-        I2C_MASTER_NUM, SHTC3_ADDR, wake_cmd, sizeof(wake_cmd), pdMS_TO_TICKS(100)
-    );
-    vTaskDelay(pdMS_TO_TICKS(1));  // short pause after wakeup
+    // 2.5) Attach SHTC3 (wakes it up and checks its ID)
+    shtc3_config_t shtc3_cfg = {
+        .dev_addr = SHTC3_I2C_ADDRESS,
+        .auto_sleep = false,
+    };
+    ESP_ERROR_CHECK(shtc3_create(i2c_bus, &shtc3_cfg, &shtc3));
+
+    // Sample in the background; the POST loop only reads the latest value
+    shtc3_sampler_config_t sampler_cfg = SHTC3_SAMPLER_CONFIG_DEFAULT();
+    sampler_cfg.mode = SHTC3_MODE_NORMAL_T_FIRST_STRETCH;
+    sampler_cfg.period_ms = 500;
+    ESP_ERROR_CHECK(shtc3_sampler_create(shtc3, &sampler_cfg, &sampler));
 
     // 3) resolver info  
     const struct addrinfo hints = {
@@ -109,25 +87,23 @@ void app_main(void)
     char recv_buf[64];
 
     while (1) {
-        // 4) Read sensor
-        uint8_t data[6] = {0};
-        esp_err_t err = shtc3_read_data(data, sizeof(data));
+        // 4) Read latest sample
+        shtc3_sample_t sample;
+        esp_err_t err = shtc3_sampler_get_latest(sampler, &sample);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Sensor read failed: %s", esp_err_to_name(err));
+            ESP_LOGE(TAG, "No sensor sample yet: %s", esp_err_to_name(err));
             vTaskDelay(pdMS_TO_TICKS(1000));
             continue;
         }
 
-        uint16_t raw_t = (data[0] << 8) | data[1];
-        uint16_t raw_h = (data[3] << 8) | data[4];
-        float temp_c = convert_temperature(raw_t);
-        float hum = convert_humidity(raw_h);
+        int32_t temp_c = sample.temp_c;
+        int32_t hum = sample.humidity;
 
         char post_data[64];
         int pd_len = snprintf(
             post_data, sizeof(post_data),
-            "{\"temperature\":%.2f,\"humidity\":%.2f}",
-            temp_c, hum
+            "{\"temperature\":" SHTC3_CENTI_FMT ",\"humidity\":" SHTC3_CENTI_FMT "}",
+            SHTC3_CENTI_ARGS(temp_c), SHTC3_CENTI_ARGS(hum)
         );
 
         if (getaddrinfo(WEB_SERVER, WEB_PORT, &hints, &res) != 0) {
@@ -165,7 +141,8 @@ void app_main(void)
         while (read(sock, recv_buf, sizeof(recv_buf)-1) > 0) {}
 
         close(sock);
-        ESP_LOGI(TAG, "Posted: T=%.2fC, H=%.2f%%", temp_c, hum);
+        ESP_LOGI(TAG, "Posted: T=" SHTC3_CENTI_FMT "C, H=" SHTC3_CENTI_FMT "%%",
+                 SHTC3_CENTI_ARGS(temp_c), SHTC3_CENTI_ARGS(hum));
 
         vTaskDelay(pdMS_TO_TICKS(500));
     }
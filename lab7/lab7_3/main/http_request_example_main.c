@@ -14,72 +14,31 @@
 #include "lwip/netdb.h"
 #include "lwip/dns.h"
 
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
+#include "shtc3.h"
+#include "shtc3_sampler.h"
 
 #define I2C_MASTER_SCL_IO     8
 #define I2C_MASTER_SDA_IO     10
 #define I2C_MASTER_NUM        I2C_NUM_0
-#define I2C_MASTER_FREQ_HZ    100000
-#define SHTC3_SENSOR_ADDR     0x70
-#define CMD_WAKEUP            0x3517
-#define CMD_SLEEP             0xB098
-#define CMD_MEASURE_T_RH_CS   0x7CA2
 
 #define SERVER_IP "172.20.10.1"  // Your Pi/iSH server IP
 #define SERVER_PORT "1234"
 
 static const char *TAG = "ESP32_COMBO";
 
-// CRC helper for SHTC3
-static uint8_t crc8(const uint8_t *data, int len) {
-    uint8_t crc = 0xFF;
-    for (int i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int b = 0; b < 8; b++) {
-            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
-        }
-    }
-    return crc;
-}
-
-// I2C commands for SHTC3
-static esp_err_t write_cmd(uint16_t cmd) {
-    uint8_t buf[2] = { (uint8_t)(cmd >> 8), (uint8_t)(cmd & 0xFF) };
-    return i2c_master_write_to_device(I2C_MASTER_NUM, SHTC3_SENSOR_ADDR, buf, 2, pdMS_TO_TICKS(50));
-}
+static i2c_master_bus_handle_t i2c_bus;
+static shtc3_handle_t shtc3;
+static shtc3_sampler_handle_t sampler;
 
-static esp_err_t read_n(uint8_t *buf, size_t n) {
-    return i2c_master_read_from_device(I2C_MASTER_NUM, SHTC3_SENSOR_ADDR, buf, n, pdMS_TO_TICKS(50));
-}
-
-static esp_err_t measure_shtc3(float *t_c, float *rh) {
-    esp_err_t r;
-    if ((r = write_cmd(CMD_WAKEUP)) != ESP_OK) return r;
-    vTaskDelay(pdMS_TO_TICKS(2));
-
-    if ((r = write_cmd(CMD_MEASURE_T_RH_CS)) != ESP_OK) {
-        write_cmd(CMD_SLEEP);
-        return r;
-    }
-    vTaskDelay(pdMS_TO_TICKS(12));
+// Results in hundredths of a degree / percent
+static esp_err_t measure_shtc3(int32_t *t_c, int32_t *rh) {
+    shtc3_sample_t sample;
+    esp_err_t r = shtc3_sampler_get_latest(sampler, &sample);
+    if (r != ESP_OK) return r;
 
-    uint8_t buf[6];
-    if ((r = read_n(buf, 6)) != ESP_OK) {
-        write_cmd(CMD_SLEEP);
-        return r;
-    }
-
-    if (crc8(buf,2) != buf[2] || crc8(buf+3,2) != buf[5]) {
-        write_cmd(CMD_SLEEP);
-        return ESP_ERR_INVALID_CRC;
-    }
-
-    uint16_t rawT = (buf[0] << 8) | buf[1];
-    uint16_t rawRH = (buf[3] << 8) | buf[4];
-    *t_c = -45.0f + 175.0f * rawT / 65535.0f;
-    *rh = 100.0f * rawRH / 65535.0f;
-
-    write_cmd(CMD_SLEEP);
+    *t_c = sample.temp_c;
+    *rh = sample.humidity;
     return ESP_OK;
 }
 
@@ -141,7 +100,7 @@ static int simple_http_get(const char *host, const char *port, const char *path,
 // Main task: read sensors, get location & weather, POST data
 static void combo_task(void *pvParams) {
     while (1) {
-        float t_local, h_local;
+        int32_t t_local, h_local;
         if (measure_shtc3(&t_local, &h_local) != ESP_OK) {
             // ESP_LOGE(TAG, "Sensor read failed");
             vTaskDelay(pdMS_TO_TICKS(100));
@@ -181,8 +140,8 @@ static void combo_task(void *pvParams) {
         // Build JSON payload
         char post_data[256];
         snprintf(post_data, sizeof(post_data),
-                 "{\"location\":\"%s\",\"outdoor_temp\":\"%s\",\"local_temp\":%.2f,\"humidity\":%.2f}",
-                 loc_body, wttr_body, t_local, h_local);
+                 "{\"location\":\"%s\",\"outdoor_temp\":\"%s\",\"local_temp\":" SHTC3_CENTI_FMT ",\"humidity\":" SHTC3_CENTI_FMT "}",
+                 loc_body, wttr_body, SHTC3_CENTI_ARGS(t_local), SHTC3_CENTI_ARGS(h_local));
         ESP_LOGI(TAG, "Sending: %s", post_data);
 
         // POST to server
@@ -207,16 +166,26 @@ static void combo_task(void *pvParams) {
 }
 
 static void i2c_init() {
-    i2c_config_t cfg = {
-        .mode = I2C_MODE_MASTER,
+    i2c_master_bus_config_t cfg = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .i2c_port = I2C_MASTER_NUM,
         .sda_io_num = I2C_MASTER_SDA_IO,
         .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+    ESP_ERROR_CHECK(i2c_new_master_bus(&cfg, &i2c_bus));
+
+    // Sensor sleeps between measurements; the driver wakes it on demand
+    shtc3_config_t shtc3_cfg = {
+        .dev_addr = SHTC3_I2C_ADDRESS,
+        .auto_sleep = true,
     };
-    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &cfg));
-    ESP_ERROR_CHECK(i2c_driver_install(I2C_MASTER_NUM, cfg.mode, 0, 0, 0));
+    ESP_ERROR_CHECK(shtc3_create(i2c_bus, &shtc3_cfg, &shtc3));
+
+    shtc3_sampler_config_t sampler_cfg = SHTC3_SAMPLER_CONFIG_DEFAULT();
+    sampler_cfg.mode = SHTC3_MODE_NORMAL_T_FIRST_STRETCH;
+    ESP_ERROR_CHECK(shtc3_sampler_create(shtc3, &sampler_cfg, &sampler));
 }
 
 void app_main() {